@@ -0,0 +1,9 @@
+LOOP:	LWS F1 0(R3)
+	LWS F2 0(R4)
+	MULTS F3 F1 F2
+	ADDS F0 F0 F3
+	ADDI R3 R3 4
+	ADDI R4 R4 4
+	SUBI R2 R2 1
+	BNEZ R2 LOOP
+	EOP
@@ -0,0 +1,8 @@
+LOOP:	LWS F1 0(R3)
+	LWS F2 0(R4)
+	FMAS F0 F1 F2 F0
+	ADDI R3 R3 4
+	ADDI R4 R4 4
+	SUBI R2 R2 1
+	BNEZ R2 LOOP
+	EOP
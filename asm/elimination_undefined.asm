@@ -0,0 +1,4 @@
+XOR R0 R0 R0
+ADDI R1 R0 -1
+ADD R2 R1 R1
+EOP
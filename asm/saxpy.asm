@@ -0,0 +1,10 @@
+LOOP:	LWS F2 0(R3)
+	LWS F3 0(R4)
+	MULTS F2 F2 F1
+	ADDS F3 F3 F2
+	SWS F3 0(R4)
+	ADDI R3 R3 4
+	ADDI R4 R4 4
+	SUBI R2 R2 1
+	BNEZ R2 LOOP
+	EOP
@@ -0,0 +1,10 @@
+LOOP:	LWV V2 0(R3)
+	LWV V3 0(R4)
+	MULV V2 V2 V1
+	ADDV V3 V3 V2
+	SWV V3 0(R4)
+	ADDI R3 R3 16
+	ADDI R4 R4 16
+	SUBI R2 R2 1
+	BNEZ R2 LOOP
+	EOP
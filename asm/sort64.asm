@@ -0,0 +1,34 @@
+INIT:	XOR R0 R0 R0
+	XOR R1 R1 R1
+	ADDI R3 R0 0xA000	
+	ADDI R4 R0 0xB000
+LOOP:	LWS F2 0(R3)
+	SWS F2 0(R4)
+	ADDI R3 R3 4	
+	ADDI R4 R4 4	
+	ADDI R1 R1 1	
+	SUBI R5 R1 64
+	BNEZ R5 LOOP	
+SORT:	XOR R1 R1 R1
+	ADDI R4 R0 0xB000
+OLOOP:	LWS F3 0(R4)
+	ADDI R2 R1 1
+	ADDI R6 R4 4
+ILOOP:	LWS F5 0(R6)
+	SUBS F8 F3 F5
+	SWS F8 0xA0030(R0)
+	LW R8 0xA0030(R0)
+	AND R8 R8 R7 
+	BNEZ R8 END_IF
+	SWS F3 0(R6)
+	SWS F5 0(R4)
+	LWS  F3 0(R4) 
+END_IF:	ADDI R6 R6 4
+	ADDI R2 R2 1
+	SUBI R9 R2 64
+	BNEZ R9 ILOOP
+	ADDI R4 R4 4
+	ADDI R1 R1 1
+	SUBI R10 R1 63
+	BNEZ R10 OLOOP
+EOP	
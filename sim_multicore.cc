@@ -0,0 +1,766 @@
+#include "sim_multicore.h"
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+static const char *bus_transaction_names[NUM_BUS_TRANSACTIONS] = {"BusRd", "BusRdX", "BusUpgr", "WriteBack"};
+static const char *prefetcher_names[] = {"none", "next-line", "stride", "stream"};
+
+/* ============================================================================
+
+   System creation, initialization and deallocation
+
+   =========================================================================== */
+
+sim_multicore::sim_multicore(unsigned cores_nr,
+							 unsigned mem_size,
+							 unsigned rob_size,
+							 unsigned num_int_res_stations,
+							 unsigned num_add_res_stations,
+							 unsigned num_mul_res_stations,
+							 unsigned num_load_res_stations,
+							 unsigned issue_width)
+{
+	if (cores_nr == 0 || cores_nr > MAX_CORES)
+	{
+		cerr << "error: invalid number of cores " << cores_nr << "!" << endl;
+		exit(-1);
+	}
+	num_cores = cores_nr;
+	data_memory_size = mem_size;
+	data_memory = new unsigned char[data_memory_size];
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		cores[c] = new sim_ooo(0, rob_size, num_int_res_stations, num_add_res_stations, num_mul_res_stations, num_load_res_stations, issue_width);
+		cores[c]->attach_memory(data_memory, data_memory_size);
+		cores[c]->set_memory_hierarchy(this, c);
+		lines[c] = NULL;
+	}
+	init_caches(8 * 1024, 4, 32);
+	init_bus(2, 20, 5);
+	prefetcher = PREFETCH_NONE;
+	prefetch_degree = 1;
+	prefetch_distance = 1;
+	reset();
+}
+
+sim_multicore::~sim_multicore()
+{
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		delete cores[c];
+		delete[] lines[c];
+	}
+	delete[] data_memory;
+}
+
+void sim_multicore::init_exec_unit(exe_unit_t exec_unit, unsigned latency, unsigned instances)
+{
+	for (unsigned c = 0; c < num_cores; c++)
+		cores[c]->init_exec_unit(exec_unit, latency, instances);
+}
+
+void sim_multicore::init_caches(unsigned size, unsigned assoc, unsigned line, unsigned hit)
+{
+	if (assoc == 0 || line < 4 || (line & (line - 1)) != 0 || size < assoc * line || size % (assoc * line) != 0)
+	{
+		cerr << "error: invalid cache geometry " << size << "B, " << assoc << "-way, " << line << "B lines!" << endl;
+		exit(-1);
+	}
+	cache_sets = size / (assoc * line);
+	cache_assoc = assoc;
+	line_size = line;
+	hit_latency = hit;
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		delete[] lines[c];
+		lines[c] = new cache_line_t[cache_sets * cache_assoc];
+		for (unsigned l = 0; l < cache_sets * cache_assoc; l++)
+		{
+			lines[c][l].tag = UNDEFINED;
+			lines[c][l].state = MESI_INVALID;
+			lines[c][l].last_use = 0;
+			lines[c][l].fill_cycle = 0;
+			lines[c][l].ready_cycle = 0;
+			lines[c][l].prefetched = false;
+		}
+	}
+}
+
+void sim_multicore::init_bus(unsigned bus_cycles, unsigned mem_cycles, unsigned cache_to_cache_cycles)
+{
+	bus_latency = bus_cycles;
+	memory_latency = mem_cycles;
+	cache_to_cache_latency = cache_to_cache_cycles;
+}
+
+void sim_multicore::init_prefetcher(prefetcher_t type, unsigned degree, unsigned distance)
+{
+	if (degree == 0 || distance == 0)
+	{
+		cerr << "error: invalid prefetcher degree " << degree << " or distance " << distance << "!" << endl;
+		exit(-1);
+	}
+	prefetcher = type;
+	prefetch_degree = degree;
+	prefetch_distance = distance;
+}
+
+void sim_multicore::reset()
+{
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		cores[c]->reset();
+		for (unsigned l = 0; l < cache_sets * cache_assoc; l++)
+		{
+			lines[c][l].tag = UNDEFINED;
+			lines[c][l].state = MESI_INVALID;
+			lines[c][l].last_use = 0;
+			lines[c][l].fill_cycle = 0;
+			lines[c][l].ready_cycle = 0;
+			lines[c][l].prefetched = false;
+		}
+		memset(&cache_stats[c], 0, sizeof(cache_stats_t));
+		use_counters[c] = 0;
+		for (unsigned e = 0; e < STRIDE_TABLE_SIZE; e++)
+			stride_tables[c][e].pc = UNDEFINED;
+		for (unsigned s = 0; s < NUM_STREAMS; s++)
+			streams[c][s].last_line = UNDEFINED;
+		events[c].clear();
+	}
+	for (unsigned t = 0; t < NUM_BUS_TRANSACTIONS; t++)
+		bus_transactions[t] = 0;
+	bus_busy_cycles = 0;
+	bus_wait_cycles = 0;
+	bus_free_cycle = 0;
+	clock_cycles = 0;
+	parallel = false;
+}
+
+sim_ooo *sim_multicore::get_core(unsigned core) { return cores[core]; }
+
+unsigned sim_multicore::get_num_cores() { return num_cores; }
+
+/* ============================================================================
+
+   Caches and MESI protocol
+
+   =========================================================================== */
+
+cache_line_t *sim_multicore::find_line(unsigned core, unsigned address)
+{
+	unsigned tag = address / line_size;
+	cache_line_t *set = &lines[core][(tag % cache_sets) * cache_assoc];
+	for (unsigned w = 0; w < cache_assoc; w++)
+	{
+		if (set[w].state != MESI_INVALID && set[w].tag == tag)
+			return &set[w];
+	}
+	return NULL;
+}
+
+/* invalid lines first, then the least recently used one */
+cache_line_t *sim_multicore::victim_line(unsigned core, unsigned address)
+{
+	unsigned tag = address / line_size;
+	cache_line_t *set = &lines[core][(tag % cache_sets) * cache_assoc];
+	cache_line_t *victim = &set[0];
+	for (unsigned w = 0; w < cache_assoc; w++)
+	{
+		if (set[w].state == MESI_INVALID)
+			return &set[w];
+		if (set[w].last_use < victim->last_use)
+			victim = &set[w];
+	}
+	return victim;
+}
+
+/* the bus serves one transaction at a time, in the order in which they are requested */
+unsigned sim_multicore::bus_transaction(bus_transaction_t type, unsigned cycle)
+{
+	unsigned start = max(cycle, bus_free_cycle);
+	bus_free_cycle = start + bus_latency;
+	bus_transactions[type]++;
+	bus_busy_cycles += bus_latency;
+	bus_wait_cycles += start - cycle;
+	return start - cycle + bus_latency;
+}
+
+bool sim_multicore::snoop(unsigned core, unsigned address, bus_transaction_t type, bool *supplied)
+{
+	bool shared = false;
+	*supplied = false;
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		if (c == core)
+			continue;
+		cache_line_t *line = find_line(c, address);
+		if (line == NULL)
+			continue;
+		shared = true;
+		if (line->state == MESI_MODIFIED || line->state == MESI_EXCLUSIVE)
+		{
+			// the owner supplies the line; a MODIFIED line is flushed to memory by the same transaction, which memory
+			// snoops, so no BUS_WB is issued
+			*supplied = true;
+			cache_stats[c].interventions++;
+			if (line->state == MESI_MODIFIED)
+				cache_stats[c].flushes++;
+		}
+		if (type == BUS_RD)
+			line->state = MESI_SHARED;
+		else
+		{
+			line->state = MESI_INVALID;
+			cache_stats[c].invalidations++;
+		}
+	}
+	return shared;
+}
+
+/* during a parallel run, the other caches and the bus cannot be accessed: the transaction is queued, a miss does
+   not wait for the bus and is served by another cache if the directory says one held the line at the start of the
+   quantum, and a read miss fills the line as EXCLUSIVE (apply_events() makes it SHARED if another cache holds it) */
+unsigned sim_multicore::access(unsigned core, unsigned address, bool write, unsigned cycle, unsigned pc)
+{
+	cache_stats_t *stats = &cache_stats[core];
+	cache_line_t *line = find_line(core, address);
+	unsigned latency = hit_latency;
+	bool supplied;
+	bool trigger = line == NULL;
+
+	if (write)
+		stats->writes++;
+	else
+		stats->reads++;
+
+	if (line != NULL && line->prefetched)
+	{
+		line->prefetched = false;
+		stats->useful_prefetches++;
+		if (line->ready_cycle > cycle)
+			stats->late_prefetches++;
+		trigger = true;
+	}
+	// the data of a prefetched line may still be on its way
+	if (line != NULL && line->ready_cycle > cycle)
+		latency += line->ready_cycle - cycle;
+
+	if (line != NULL && write && line->state == MESI_SHARED)
+	{
+		// upgrade: the other copies are invalidated, no data transfer
+		stats->upgrades++;
+		if (parallel)
+		{
+			coherence_event_t event = {cycle, core, address, BUS_UPGR};
+			events[core].push_back(event);
+			latency += bus_latency;
+		}
+		else
+		{
+			latency += bus_transaction(BUS_UPGR, cycle);
+			snoop(core, address, BUS_UPGR, &supplied);
+		}
+		line->state = MESI_MODIFIED;
+		line->fill_cycle = cycle;
+	}
+	else if (line != NULL)
+	{
+		if (write)
+			line->state = MESI_MODIFIED;
+	}
+	else
+	{
+		if (write)
+			stats->write_misses++;
+		else
+			stats->read_misses++;
+		bus_transaction_t type = write ? BUS_RDX : BUS_RD;
+		bool shared = false;
+		if (parallel)
+		{
+			coherence_event_t event = {cycle, core, address, type};
+			events[core].push_back(event);
+			unordered_map<unsigned, unsigned long long>::const_iterator holders = directory.find(address / line_size);
+			supplied = holders != directory.end() && (holders->second & ~(1ULL << core)) != 0;
+			latency += bus_latency + (supplied ? cache_to_cache_latency : memory_latency);
+		}
+		else
+		{
+			latency += bus_transaction(type, cycle);
+			shared = snoop(core, address, type, &supplied);
+			latency += supplied ? cache_to_cache_latency : memory_latency;
+		}
+
+		line = victim_line(core, address);
+		evict(core, line, cycle + latency);
+		line->tag = address / line_size;
+		if (write)
+			line->state = MESI_MODIFIED;
+		else
+			line->state = shared ? MESI_SHARED : MESI_EXCLUSIVE;
+		line->fill_cycle = cycle;
+		line->ready_cycle = 0;
+		line->prefetched = false;
+	}
+	line->last_use = ++use_counters[core];
+	stats->miss_cycles += latency - hit_latency;
+
+	if (prefetcher != PREFETCH_NONE)
+		train_prefetcher(core, pc, address, trigger, cycle);
+	return latency;
+}
+
+/* a load reads the bytes buffered by the earlier stores of its core, and the shared memory for the others (which no
+   core writes during the quantum) */
+bool sim_multicore::load(unsigned core, unsigned address, unsigned *value)
+{
+	if (!parallel || stored_bytes[core].empty())
+		return false;
+	*value = 0;
+	for (unsigned b = 0; b < 4; b++)
+	{
+		unordered_map<unsigned, unsigned char>::iterator stored = stored_bytes[core].find(address + b);
+		unsigned char byte = stored != stored_bytes[core].end() ? stored->second : data_memory[address + b];
+		*value |= (unsigned)byte << (8 * b);
+	}
+	return true;
+}
+
+bool sim_multicore::store(unsigned core, unsigned address, unsigned value, unsigned cycle)
+{
+	if (!parallel)
+		return false;
+	store_event_t event = {cycle, core, address, value};
+	stores[core].push_back(event);
+	for (unsigned b = 0; b < 4; b++)
+		stored_bytes[core][address + b] = (value >> (8 * b)) & 0xFF;
+	return true;
+}
+
+/* the evicted line is written back through a write buffer, after the miss is served */
+void sim_multicore::evict(unsigned core, cache_line_t *line, unsigned cycle)
+{
+	if (line->state != MESI_INVALID && line->prefetched)
+		cache_stats[core].useless_prefetches++;
+	if (line->state != MESI_MODIFIED)
+		return;
+	cache_stats[core].writebacks++;
+	if (parallel)
+	{
+		coherence_event_t event = {cycle, core, line->tag * line_size, BUS_WB};
+		events[core].push_back(event);
+	}
+	else
+		bus_transaction(BUS_WB, cycle);
+}
+
+/* ============================================================================
+
+   Prefetchers
+
+   =========================================================================== */
+
+/* a prefetch is a read miss that does not stall the core: the line is filled right away, but its data can only be
+   used once the transaction completes */
+void sim_multicore::prefetch(unsigned core, unsigned address, unsigned cycle)
+{
+	if (address >= data_memory_size || find_line(core, address) != NULL)
+		return;
+	unsigned latency;
+	bool supplied;
+	bool shared = false;
+	if (parallel)
+	{
+		coherence_event_t event = {cycle, core, address, BUS_RD};
+		events[core].push_back(event);
+		unordered_map<unsigned, unsigned long long>::const_iterator holders = directory.find(address / line_size);
+		supplied = holders != directory.end() && (holders->second & ~(1ULL << core)) != 0;
+		latency = bus_latency + (supplied ? cache_to_cache_latency : memory_latency);
+	}
+	else
+	{
+		latency = bus_transaction(BUS_RD, cycle);
+		shared = snoop(core, address, BUS_RD, &supplied);
+		latency += supplied ? cache_to_cache_latency : memory_latency;
+	}
+	cache_stats[core].prefetches++;
+
+	cache_line_t *line = victim_line(core, address);
+	evict(core, line, cycle + latency);
+	line->tag = address / line_size;
+	line->state = shared ? MESI_SHARED : MESI_EXCLUSIVE;
+	line->fill_cycle = cycle;
+	line->ready_cycle = cycle + latency;
+	line->prefetched = true;
+	line->last_use = ++use_counters[core];
+}
+
+void sim_multicore::train_prefetcher(unsigned core, unsigned pc, unsigned address, bool trigger, unsigned cycle)
+{
+	if (prefetcher == PREFETCH_NEXT_LINE && trigger)
+	{
+		unsigned line = address / line_size;
+		for (unsigned d = 0; d < prefetch_degree; d++)
+			prefetch(core, (line + prefetch_distance + d) * line_size, cycle);
+	}
+	else if (prefetcher == PREFETCH_STRIDE && pc != UNDEFINED)
+	{
+		stride_entry_t *entry = &stride_tables[core][(pc / 4) % STRIDE_TABLE_SIZE];
+		if (entry->pc != pc)
+		{
+			entry->pc = pc;
+			entry->last_address = address;
+			entry->stride = 0;
+			entry->confirmed = false;
+			return;
+		}
+		int stride = address - entry->last_address;
+		entry->confirmed = stride != 0 && stride == entry->stride;
+		entry->stride = stride;
+		entry->last_address = address;
+		if (!entry->confirmed)
+			return;
+		// strides shorter than a line would prefetch the line being accessed
+		int step = stride;
+		if (step > 0 && step < (int)line_size)
+			step = line_size;
+		else if (step < 0 && -step < (int)line_size)
+			step = -(int)line_size;
+		for (unsigned d = 0; d < prefetch_degree; d++)
+			prefetch(core, address + step * (int)(prefetch_distance + d), cycle);
+	}
+	else if (prefetcher == PREFETCH_STREAM && trigger)
+	{
+		unsigned line = address / line_size;
+		stream_entry_t *stream = NULL;
+		stream_entry_t *victim = &streams[core][0];
+		for (unsigned s = 0; s < NUM_STREAMS && stream == NULL; s++)
+		{
+			stream_entry_t *entry = &streams[core][s];
+			if (entry->last_line != UNDEFINED && (entry->direction != 0 ? line == entry->last_line + entry->direction : line == entry->last_line + 1 || line == entry->last_line - 1))
+				stream = entry;
+			else if (victim->last_line != UNDEFINED && (entry->last_line == UNDEFINED || entry->last_use < victim->last_use))
+				victim = entry;
+		}
+		if (stream == NULL)
+		{
+			// a new stream is only confirmed by a trigger on the next or on the previous line
+			victim->last_line = line;
+			victim->direction = 0;
+			victim->last_use = ++use_counters[core];
+			return;
+		}
+		if (stream->direction == 0)
+		{
+			stream->direction = line > stream->last_line ? 1 : -1;
+			stream->next_line = line + stream->direction;
+		}
+		stream->last_line = line;
+		stream->last_use = ++use_counters[core];
+		if ((int)(stream->next_line - line) * stream->direction <= 0)
+			stream->next_line = line + stream->direction;
+		for (unsigned d = 0; d < prefetch_degree && (int)(stream->next_line - line) * stream->direction <= (int)prefetch_distance; d++)
+		{
+			prefetch(core, stream->next_line * line_size, cycle);
+			stream->next_line += stream->direction;
+		}
+	}
+}
+
+/* orders the queued transactions by clock cycle, then by core */
+static bool earlier_event(const coherence_event_t &a, const coherence_event_t &b)
+{
+	return a.cycle < b.cycle || (a.cycle == b.cycle && a.core < b.core);
+}
+
+static bool earlier_store(const store_event_t &a, const store_event_t &b)
+{
+	return a.cycle < b.cycle || (a.cycle == b.cycle && a.core < b.core);
+}
+
+void sim_multicore::apply_events()
+{
+	//the stores of each core are in program order, which the stable sort keeps within a clock cycle
+	vector<store_event_t> all_stores;
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		all_stores.insert(all_stores.end(), stores[c].begin(), stores[c].end());
+		stores[c].clear();
+		stored_bytes[c].clear();
+	}
+	stable_sort(all_stores.begin(), all_stores.end(), earlier_store);
+	for (unsigned s = 0; s < all_stores.size(); s++)
+		write_memory(all_stores[s].address, all_stores[s].value);
+
+	vector<coherence_event_t> all;
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		all.insert(all.end(), events[c].begin(), events[c].end());
+		events[c].clear();
+	}
+	stable_sort(all.begin(), all.end(), earlier_event);
+
+	for (unsigned e = 0; e < all.size(); e++)
+	{
+		coherence_event_t *event = &all[e];
+		bus_transaction(event->type, event->cycle);
+		if (event->type == BUS_WB)
+			continue;
+		// only the copies filled before the transaction are affected: the later ones issued their own transactions
+		bool shared = false;
+		for (unsigned c = 0; c < num_cores; c++)
+		{
+			cache_line_t *line = c == event->core ? NULL : find_line(c, event->address);
+			if (line == NULL || line->fill_cycle > event->cycle)
+				continue;
+			shared = true;
+			if (line->state == MESI_MODIFIED || line->state == MESI_EXCLUSIVE)
+			{
+				cache_stats[c].interventions++;
+				if (line->state == MESI_MODIFIED)
+					cache_stats[c].flushes++;
+			}
+			if (event->type == BUS_RD)
+				line->state = MESI_SHARED;
+			else
+			{
+				line->state = MESI_INVALID;
+				cache_stats[c].invalidations++;
+			}
+		}
+		// a copy invalidated by a conflicting transaction of another core in the same clock cycle is filled again:
+		// that transaction was ordered first on the bus, so this one is served after it
+		cache_line_t *line = find_line(event->core, event->address);
+		if (line == NULL)
+		{
+			unsigned tag = event->address / line_size;
+			cache_line_t *set = &lines[event->core][(tag % cache_sets) * cache_assoc];
+			for (unsigned w = 0; w < cache_assoc && line == NULL; w++)
+			{
+				if (set[w].tag == tag && set[w].fill_cycle == event->cycle)
+				{
+					line = &set[w];
+					line->state = event->type == BUS_RD ? MESI_SHARED : MESI_MODIFIED;
+				}
+			}
+		}
+		// a line filled as EXCLUSIVE by a read miss is shared with the other copies; if it has been written
+		// in the meantime, the write is an upgrade that invalidates them
+		if (event->type != BUS_RD || !shared || line == NULL || line->fill_cycle != event->cycle)
+			continue;
+		if (line->state == MESI_EXCLUSIVE)
+			line->state = MESI_SHARED;
+		else if (line->state == MESI_MODIFIED)
+		{
+			cache_stats[event->core].upgrades++;
+			bus_transaction(BUS_UPGR, event->cycle);
+			for (unsigned c = 0; c < num_cores; c++)
+			{
+				cache_line_t *other = c == event->core ? NULL : find_line(c, event->address);
+				if (other != NULL && other->fill_cycle <= event->cycle)
+				{
+					other->state = MESI_INVALID;
+					cache_stats[c].invalidations++;
+				}
+			}
+		}
+	}
+}
+
+void sim_multicore::build_directory()
+{
+	directory.clear();
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		for (unsigned l = 0; l < cache_sets * cache_assoc; l++)
+		{
+			if (lines[c][l].state != MESI_INVALID)
+				directory[lines[c][l].tag] |= 1ULL << c;
+		}
+	}
+}
+
+/* ============================================================================
+
+   Simulation and statistics
+
+   =========================================================================== */
+
+/* the cores are stepped in lockstep; the first core to access the bus changes every clock cycle */
+void sim_multicore::run(unsigned cycles)
+{
+	for (unsigned n = 0; cycles == 0 || n < cycles; n++)
+	{
+		bool active = false;
+		for (unsigned k = 0; k < num_cores; k++)
+		{
+			sim_ooo *core = cores[(clock_cycles + k) % num_cores];
+			if (!core->program_completed())
+			{
+				core->run(1);
+				active = true;
+			}
+		}
+		if (!active)
+			break;
+		clock_cycles++;
+	}
+}
+
+/* reusable barrier for the host threads of a parallel run */
+class host_barrier
+{
+	mutex lock;
+	condition_variable released;
+	unsigned participants;
+	unsigned waiting;
+	unsigned generation;
+
+public:
+	host_barrier(unsigned n) : participants(n), waiting(0), generation(0) {}
+
+	void wait()
+	{
+		unique_lock<mutex> guard(lock);
+		unsigned current = generation;
+		if (++waiting == participants)
+		{
+			waiting = 0;
+			generation++;
+			released.notify_all();
+		}
+		else
+			released.wait(guard, [&]
+						  { return current != generation; });
+	}
+};
+
+/* the main thread and the core threads meet at the barrier at the start and at the end of each quantum;
+   between quanta, the main thread applies the queued coherence transactions and decides whether to continue */
+void sim_multicore::run_parallel(unsigned quantum, unsigned cycles)
+{
+	if (quantum == 0)
+		quantum = 1;
+	host_barrier barrier(num_cores + 1);
+	bool stop = false;
+	unsigned length = 0;
+	vector<thread> workers;
+	parallel = true;
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		workers.push_back(thread([&, c]()
+								 {
+			while (true)
+			{
+				barrier.wait();
+				if (stop)
+					return;
+				for (unsigned n = 0; n < length && !cores[c]->program_completed(); n++)
+					cores[c]->run(1);
+				barrier.wait();
+			} }));
+	}
+
+	unsigned simulated = 0;
+	while (cycles == 0 || simulated < cycles)
+	{
+		bool active = false;
+		for (unsigned c = 0; c < num_cores; c++)
+		{
+			if (!cores[c]->program_completed())
+				active = true;
+		}
+		if (!active)
+			break;
+		length = cycles == 0 ? quantum : min(quantum, cycles - simulated);
+		build_directory();
+		barrier.wait();
+		barrier.wait();
+		apply_events();
+		simulated += length;
+		for (unsigned c = 0; c < num_cores; c++)
+			clock_cycles = max(clock_cycles, cores[c]->get_clock_cycles());
+	}
+	stop = true;
+	barrier.wait();
+	for (unsigned w = 0; w < workers.size(); w++)
+		workers[w].join();
+	parallel = false;
+	directory.clear();
+}
+
+unsigned sim_multicore::get_clock_cycles() { return clock_cycles; }
+
+cache_stats_t sim_multicore::get_cache_stats(unsigned core) { return cache_stats[core]; }
+
+unsigned long long sim_multicore::get_bus_transactions(bus_transaction_t type) { return bus_transactions[type]; }
+
+void sim_multicore::write_memory(unsigned address, unsigned value)
+{
+	cores[0]->write_memory(address, value);
+}
+
+void sim_multicore::print_memory(unsigned start_address, unsigned end_address)
+{
+	cores[0]->print_memory(start_address, end_address);
+}
+
+void sim_multicore::print_stats()
+{
+	cout << "CORES" << endl;
+	cout << setfill(' ') << setw(4) << "Core" << setw(10) << "Instr" << setw(10) << "Cycles" << setw(7) << "IPC";
+	cout << setw(9) << "Reads" << setw(9) << "Writes" << setw(9) << "RdMiss" << setw(9) << "WrMiss" << setw(8) << "Upgr" << setw(8) << "Inval" << setw(8) << "Interv" << setw(8) << "WB" << setw(8) << "Flush" << setw(8) << "Hit%" << setw(11) << "MissCyc" << endl;
+	unsigned long long instructions = 0;
+	streamsize precision = cout.precision();
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		cache_stats_t *stats = &cache_stats[c];
+		unsigned long long accesses = stats->reads + stats->writes;
+		unsigned long long misses = stats->read_misses + stats->write_misses + stats->upgrades;
+		instructions += cores[c]->get_instructions_executed();
+		cout << dec << setw(4) << c << setw(10) << cores[c]->get_instructions_executed() << setw(10) << cores[c]->get_clock_cycles();
+		cout << fixed << setprecision(3) << setw(7) << cores[c]->get_IPC();
+		cout << setw(9) << stats->reads << setw(9) << stats->writes << setw(9) << stats->read_misses << setw(9) << stats->write_misses;
+		cout << setw(8) << stats->upgrades << setw(8) << stats->invalidations << setw(8) << stats->interventions << setw(8) << stats->writebacks << setw(8) << stats->flushes;
+		cout << setprecision(1) << setw(8) << (accesses ? 100.0 * (accesses - misses) / accesses : 0.0) << setw(11) << stats->miss_cycles << endl;
+	}
+	cout << "Total instructions = " << instructions << ", clock cycles = " << clock_cycles << ", aggregate IPC = " << setprecision(3) << (clock_cycles ? (float)instructions / clock_cycles : 0) << endl;
+	cout << endl;
+
+	if (prefetcher != PREFETCH_NONE)
+	{
+		// accuracy: useful / issued; coverage: misses removed by the prefetcher; timely: useful prefetches that were not late
+		cout << "PREFETCHER (" << prefetcher_names[prefetcher] << ", degree " << prefetch_degree << ", distance " << prefetch_distance << ")" << endl;
+		cout << setw(4) << "Core" << setw(10) << "Issued" << setw(10) << "Useful" << setw(8) << "Late" << setw(9) << "Useless" << setw(11) << "Accuracy%" << setw(11) << "Coverage%" << setw(9) << "Timely%" << endl;
+		for (unsigned c = 0; c < num_cores; c++)
+		{
+			cache_stats_t *stats = &cache_stats[c];
+			unsigned long long misses = stats->read_misses + stats->write_misses;
+			cout << setw(4) << c << setw(10) << stats->prefetches << setw(10) << stats->useful_prefetches << setw(8) << stats->late_prefetches << setw(9) << stats->useless_prefetches;
+			cout << setprecision(1) << setw(11) << (stats->prefetches ? 100.0 * stats->useful_prefetches / stats->prefetches : 0.0);
+			cout << setw(11) << (stats->useful_prefetches + misses ? 100.0 * stats->useful_prefetches / (stats->useful_prefetches + misses) : 0.0);
+			cout << setw(9) << (stats->useful_prefetches ? 100.0 * (stats->useful_prefetches - stats->late_prefetches) / stats->useful_prefetches : 0.0) << endl;
+		}
+		cout << endl;
+	}
+
+	cout << "BUS" << endl;
+	unsigned long long total = 0;
+	for (unsigned t = 0; t < NUM_BUS_TRANSACTIONS; t++)
+	{
+		cout << setw(10) << bus_transaction_names[t] << setw(10) << bus_transactions[t] << endl;
+		total += bus_transactions[t];
+	}
+	cout << setw(10) << "Total" << setw(10) << total << endl;
+	cout << "Busy cycles = " << bus_busy_cycles << " (" << setprecision(1) << (clock_cycles ? 100.0 * bus_busy_cycles / clock_cycles : 0.0) << "% utilization), wait cycles = " << bus_wait_cycles << endl;
+	cout.unsetf(ios::floatfield);
+	cout.precision(precision);
+	cout << endl;
+}
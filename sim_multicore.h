@@ -0,0 +1,267 @@
+#ifndef SIM_MULTICORE_H_
+#define SIM_MULTICORE_H_
+
+#include "sim_ooo.h"
+#include <vector>
+#include <unordered_map>
+
+#define MAX_CORES 64
+#define NUM_BUS_TRANSACTIONS 4
+#define STRIDE_TABLE_SIZE 64 // entries of the per-PC stride table of each core
+#define NUM_STREAMS 8		 // streams tracked by the stream prefetcher of each core
+
+// MESI states of a cache line
+typedef enum
+{
+	MESI_INVALID,
+	MESI_SHARED,
+	MESI_EXCLUSIVE,
+	MESI_MODIFIED
+} mesi_state_t;
+
+// bus transactions
+typedef enum
+{
+	BUS_RD,	  // read miss
+	BUS_RDX,  // write miss (read with intent to modify, invalidates the other copies)
+	BUS_UPGR, // write hit on a SHARED line (invalidates the other copies)
+	BUS_WB	  // write-back of a MODIFIED line to memory
+} bus_transaction_t;
+
+// hardware prefetchers of the private caches; a "trigger" is a miss or the first access to a prefetched line
+typedef enum
+{
+	PREFETCH_NONE,
+	PREFETCH_NEXT_LINE, // a trigger on line L fetches lines L+distance ... L+distance+degree-1
+	PREFETCH_STRIDE,	// per-PC stride table: once an instruction repeats its stride, each of its accesses fetches "degree"
+						// strides starting "distance" strides ahead (strides shorter than a line count as one line)
+	PREFETCH_STREAM		// stream buffer: triggers on two consecutive lines start a stream, which then fetches up to "degree"
+						// lines per trigger, staying at most "distance" lines ahead of the accesses
+} prefetcher_t;
+
+// cache line (only tags and states are modeled: the data is always read from and written to the shared memory)
+typedef struct
+{
+	unsigned tag;		// line address (address / line size)
+	mesi_state_t state; // coherence state
+	unsigned last_use;	// timestamp of the last access (for LRU replacement)
+	unsigned fill_cycle; // clock cycle in which the line was filled or upgraded
+	unsigned ready_cycle; // clock cycle in which the data of a prefetched line arrives
+	bool prefetched;	 // filled by the prefetcher and not accessed yet
+} cache_line_t;
+
+// entry of the per-PC stride table
+typedef struct
+{
+	unsigned pc;		   // memory instruction (UNDEFINED: free entry)
+	unsigned last_address; // address of its last access
+	int stride;			   // difference between its last two addresses
+	bool confirmed;		   // the last two strides were equal
+} stride_entry_t;
+
+// stream tracked by the stream prefetcher
+typedef struct
+{
+	unsigned last_line; // line of the last trigger (UNDEFINED: free entry)
+	unsigned next_line; // next line to be prefetched
+	int direction;		// +1 or -1 (0: a single trigger seen so far)
+	unsigned last_use;	// timestamp of the last trigger (for LRU replacement)
+} stream_entry_t;
+
+// bus transaction issued by a core during a quantum of a parallel run, applied to the other caches at the end of the quantum
+typedef struct
+{
+	unsigned cycle;			// clock cycle of the transaction
+	unsigned core;			// requesting core
+	unsigned address;		// address of the access
+	bus_transaction_t type; // transaction
+} coherence_event_t;
+
+// store of a core during a quantum of a parallel run, written to the shared memory at the end of the quantum
+typedef struct
+{
+	unsigned cycle;	  // clock cycle of the store
+	unsigned core;	  // storing core
+	unsigned address; // address of the word
+	unsigned value;	  // value written
+} store_event_t;
+
+// statistics of a private cache
+typedef struct
+{
+	unsigned long long reads;		   // loads
+	unsigned long long writes;		   // stores
+	unsigned long long read_misses;	   // loads that missed
+	unsigned long long write_misses;   // stores that missed
+	unsigned long long upgrades;	   // stores that hit a SHARED line
+	unsigned long long invalidations;  // lines invalidated by the stores of other cores
+	unsigned long long interventions;  // misses of other cores served by this cache
+	unsigned long long writebacks;	   // MODIFIED lines evicted and written back to memory (BUS_WB transactions)
+	unsigned long long flushes;		   // MODIFIED lines supplied to other cores and flushed to memory by their transactions
+	unsigned long long miss_cycles;	   // clock cycles added to the memory accesses by misses, upgrades and late prefetches
+	unsigned long long prefetches;	   // lines fetched by the prefetcher
+	unsigned long long useful_prefetches; // prefetched lines accessed before being evicted or invalidated
+	unsigned long long late_prefetches;	  // useful prefetches whose data had not arrived yet at the first access
+	unsigned long long useless_prefetches; // prefetched lines evicted without being accessed
+} cache_stats_t;
+
+// multicore system: several sim_ooo cores sharing one data memory through private caches kept coherent
+// by a snooping MESI protocol over a shared bus
+class sim_multicore : public memory_hierarchy
+{
+	//cores
+	unsigned num_cores;
+	sim_ooo *cores[MAX_CORES];
+
+	//shared data memory
+	unsigned char *data_memory;
+	unsigned data_memory_size;
+
+	//private caches: lines[core][set * assoc + way]
+	unsigned cache_sets;
+	unsigned cache_assoc;
+	unsigned line_size;
+	unsigned hit_latency;
+	cache_line_t *lines[MAX_CORES];
+	cache_stats_t cache_stats[MAX_CORES];
+	unsigned use_counters[MAX_CORES];
+
+	//prefetchers
+	prefetcher_t prefetcher;
+	unsigned prefetch_degree;
+	unsigned prefetch_distance;
+	stride_entry_t stride_tables[MAX_CORES][STRIDE_TABLE_SIZE];
+	stream_entry_t streams[MAX_CORES][NUM_STREAMS];
+
+	//bus and memory
+	unsigned bus_latency;			 // clock cycles a transaction holds the bus
+	unsigned memory_latency;		 // clock cycles to read a line from memory
+	unsigned cache_to_cache_latency; // clock cycles to transfer a line from another cache
+	unsigned bus_free_cycle;		 // first clock cycle in which the bus is free
+	unsigned long long bus_transactions[NUM_BUS_TRANSACTIONS];
+	unsigned long long bus_busy_cycles;
+	unsigned long long bus_wait_cycles;
+
+	//clock cycles
+	unsigned clock_cycles;
+
+	//true during a parallel run: the cores only access their own cache, and their bus transactions are queued
+	bool parallel;
+	vector<coherence_event_t> events[MAX_CORES];
+
+	//during a parallel run, the stores of each core and the bytes they wrote, which only the later loads of the same
+	//core see until the end of the quantum
+	vector<store_event_t> stores[MAX_CORES];
+	unordered_map<unsigned, unsigned char> stored_bytes[MAX_CORES];
+
+	//during a parallel run, the cores holding a valid copy of each line (bit mask indexed by line address) at the
+	//start of the quantum; read-only while the core threads run
+	unordered_map<unsigned, unsigned long long> directory;
+
+	//rebuilds the directory from the caches
+	void build_directory();
+
+	//applies the bus transactions queued during a quantum to the bus and to the other caches, and the buffered stores
+	//to the shared memory, in clock cycle order
+	void apply_events();
+
+	//returns the line holding "address" in the cache of "core" (NULL on a miss)
+	cache_line_t *find_line(unsigned core, unsigned address);
+
+	//returns the line of the set of "address" to be replaced in the cache of "core"
+	cache_line_t *victim_line(unsigned core, unsigned address);
+
+	//reserves the bus for a transaction starting no earlier than "cycle"; returns the cycles until the transaction ends
+	unsigned bus_transaction(bus_transaction_t type, unsigned cycle);
+
+	//applies a bus transaction of "core" to the other caches; returns true if another cache holds the line
+	bool snoop(unsigned core, unsigned address, bus_transaction_t type, bool *supplied);
+
+	//replaces "line" in the cache of "core", writing it back if it is MODIFIED, after a miss served at "cycle"
+	void evict(unsigned core, cache_line_t *line, unsigned cycle);
+
+	//fetches the line of "address" into the cache of "core" with a read transaction, unless it is already cached
+	void prefetch(unsigned core, unsigned address, unsigned cycle);
+
+	//updates the prefetcher of "core" with an access of instruction "pc"; "trigger" is true on a miss or on the
+	//first access to a prefetched line
+	void train_prefetcher(unsigned core, unsigned pc, unsigned address, bool trigger, unsigned cycle);
+
+public:
+	//instantiates "num_cores" identical cores sharing "mem_size" bytes of data memory (see sim_ooo::sim_ooo for the other parameters)
+	sim_multicore(unsigned num_cores,
+				  unsigned mem_size,
+				  unsigned rob_size,
+				  unsigned num_int_res_stations,
+				  unsigned num_add_res_stations,
+				  unsigned num_mul_res_stations,
+				  unsigned num_load_buffers,
+				  unsigned issue_width = 1);
+
+	//de-allocates the cores, the caches and the shared memory
+	~sim_multicore();
+
+	//returns a core (to load its program and initialize its registers)
+	sim_ooo *get_core(unsigned core);
+
+	//returns the number of cores
+	unsigned get_num_cores();
+
+	//adds execution units to every core (see sim_ooo::init_exec_unit)
+	void init_exec_unit(exe_unit_t exec_unit, unsigned latency, unsigned instances = 1);
+
+	//configures the private caches (the default is 8KB, 4-way, 32B lines, 1 cycle hit latency)
+	// - size: cache size in bytes
+	// - assoc: associativity
+	// - line: line size in bytes
+	// - hit: clock cycles added to the memory unit latency by a hit
+	void init_caches(unsigned size, unsigned assoc, unsigned line, unsigned hit = 1);
+
+	//configures the bus (the default is 2 cycles per transaction, 20 cycles memory latency, 5 cycles cache-to-cache transfers)
+	void init_bus(unsigned bus_cycles, unsigned mem_cycles, unsigned cache_to_cache_cycles);
+
+	//configures the prefetcher of the private caches (see prefetcher_t; the default is PREFETCH_NONE); the prefetched
+	//lines use the bus like read misses
+	void init_prefetcher(prefetcher_t type, unsigned degree = 1, unsigned distance = 1);
+
+	//models the timing of a load or a store of "core" (memory_hierarchy interface)
+	unsigned access(unsigned core, unsigned address, bool write, unsigned cycle, unsigned pc);
+
+	//functional accesses of "core" (memory_hierarchy interface): only served during a parallel run, when the stores
+	//are buffered until the end of the quantum
+	bool load(unsigned core, unsigned address, unsigned *value);
+	bool store(unsigned core, unsigned address, unsigned value, unsigned cycle);
+
+	//runs all the cores for "cycles" clock cycles (until all the programs complete if cycles=0)
+	void run(unsigned cycles = 0);
+
+	//same as run(), but each core is simulated by its own host thread; the threads synchronize every "quantum" clock
+	//cycles, when the coherence transactions and the stores of the quantum are exchanged. Within a quantum, a miss
+	//does not wait for the bus and sees the other caches as they were at the start of the quantum, and a load only
+	//sees the stores of the other cores of the previous quanta, so the results differ from run() more and more as
+	//the quantum grows.
+	void run_parallel(unsigned quantum, unsigned cycles = 0);
+
+	//invalidates all the caches, clears the statistics and the shared memory, and resets the cores
+	void reset();
+
+	//returns the number of clock cycles
+	unsigned get_clock_cycles();
+
+	//returns the statistics of the cache of a core
+	cache_stats_t get_cache_stats(unsigned core);
+
+	//returns the number of bus transactions of a given type
+	unsigned long long get_bus_transactions(bus_transaction_t type);
+
+	//writes a 32-bit value to the shared memory (bypassing the caches)
+	void write_memory(unsigned address, unsigned value);
+
+	//prints the content of the shared memory within the specified address range
+	void print_memory(unsigned start_address, unsigned end_address);
+
+	//prints the per-core execution, cache and prefetcher statistics and the bus statistics
+	void print_stats();
+};
+
+#endif /*SIM_MULTICORE_H_*/
@@ -6,25 +6,37 @@
 #include <string>
 #include <iomanip>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
+//compile with -DDEBUG_OOO to trace the progress of the simulator on the standard output
+#ifdef DEBUG_OOO
+#define TRACE(x) cout << x
+#else
+#define TRACE(x)
+#endif
+
 //used for debugging purposes
 static const char *stage_names[NUM_STAGES] = {"ISSUE", "EXE", "WR", "COMMIT"};
-static const char *instr_names[NUM_OPCODES] = {"LW", "SW", "ADD", "ADDI", "SUB", "SUBI", "XOR", "AND", "MULT", "DIV", "BEQZ", "BNEZ", "BLTZ", "BGTZ", "BLEZ", "BGEZ", "JUMP", "EOP", "LWS", "SWS", "ADDS", "SUBS", "MULTS", "DIVS"};
-static const char *res_station_names[5] = {"Int", "Add", "Mult", "Load"};
-
-float FP_regs[NUM_GP_REGISTERS];
-int INT_regs[NUM_GP_REGISTERS];
-int PC;
-int FP_tags[NUM_GP_REGISTERS];
-int INT_tags[NUM_GP_REGISTERS];
-int ROBindex4ResStations;
-int ROBentryIndex;
-bool vacantPlace;
+static const char *instr_names[NUM_OPCODES] = {"LW", "SW", "ADD", "ADDI", "SUB", "SUBI", "XOR", "AND", "MULT", "DIV", "BEQZ", "BNEZ", "BLTZ", "BGTZ", "BLEZ", "BGEZ", "JUMP", "EOP", "LWS", "SWS", "ADDS", "SUBS", "MULTS", "DIVS", "LWV", "SWV", "ADDV", "SUBV", "MULV", "FMAS"};
+static const char *res_station_names[NUM_RS_TYPES] = {"Int", "Add", "Mult", "Load", "Vec"};
+static const char *stall_names[NUM_STALL_CAUSES] = {"ROB", "RS", "Opnd", "Unit", "Mem", "PRF", "Fetch"};
+static const char *unit_names[NUM_UNIT_TYPES] = {"INTEGER", "ADDER", "MULTIPLIER", "DIVIDER", "MEMORY", "VECTOR", "FMA"};
 
-//stall flags
-bool issue_struct_stall;
+static const char *fetch_policy_names[2] = {"round-robin", "ICOUNT"};
+static const char *prf_names[NUM_PRF_TYPES] = {"INT", "FP"};
+static const char *energy_event_names[NUM_ENERGY_EVENTS] = {"RS write", "CDB broadcast", "ROB read", "ROB write", "RF read", "RF write", "Memory read", "Memory write"};
+static const char *leakage_names[NUM_LEAKAGE_STRUCTURES] = {"ROB", "RS", "Registers", "Units"};
 
 /* =============================================================
 
@@ -33,7 +45,7 @@ bool issue_struct_stall;
    ============================================================= */
 
 /* convert a float into an unsigned */
-inline unsigned float2unsigned(float value)
+unsigned float2unsigned(float value)
 {
 	unsigned result;
 	memcpy(&result, &value, sizeof value);
@@ -41,7 +53,7 @@ inline unsigned float2unsigned(float value)
 }
 
 /* convert an unsigned into a float */
-inline float unsigned2float(unsigned value)
+float unsigned2float(unsigned value)
 {
 	float result;
 	memcpy(&result, &value, sizeof value);
@@ -63,7 +75,7 @@ inline unsigned char2unsigned(unsigned char *buffer)
 	return buffer[0] + (buffer[1] << 8) + (buffer[2] << 16) + (buffer[3] << 24);
 }
 
-/* the following six functions return the kind of the considered opcdoe */
+/* the following functions return the kind of the considered opcdoe */
 
 bool is_branch(opcode_t opcode)
 {
@@ -72,7 +84,27 @@ bool is_branch(opcode_t opcode)
 
 bool is_memory(opcode_t opcode)
 {
-	return (opcode == LW || opcode == SW || opcode == LWS || opcode == SWS);
+	return (opcode == LW || opcode == SW || opcode == LWS || opcode == SWS || opcode == LWV || opcode == SWV);
+}
+
+bool is_load(opcode_t opcode)
+{
+	return (opcode == LW || opcode == LWS || opcode == LWV);
+}
+
+bool is_store(opcode_t opcode)
+{
+	return (opcode == SWS || opcode == SWV);
+}
+
+bool is_vector_alu(opcode_t opcode)
+{
+	return (opcode == ADDV || opcode == SUBV || opcode == MULV);
+}
+
+bool is_vector(opcode_t opcode)
+{
+	return (is_vector_alu(opcode) || opcode == LWV || opcode == SWV);
 }
 
 bool is_int_r(opcode_t opcode)
@@ -92,7 +124,25 @@ bool is_int(opcode_t opcode)
 
 bool is_fp_alu(opcode_t opcode)
 {
-	return (opcode == ADDS || opcode == SUBS || opcode == MULTS || opcode == DIVS);
+	return (opcode == ADDS || opcode == SUBS || opcode == MULTS || opcode == DIVS || opcode == FMAS);
+}
+
+bool writes_register(opcode_t opcode)
+{
+	return (is_int(opcode) || is_fp_alu(opcode) || opcode == LW || opcode == LWS);
+}
+
+/* macro-op fusion pairs: an immediate add or subtract followed by a conditional branch on its result, or by a scalar
+   load using its result as base address */
+bool fusable(const instruction_t &first, const instruction_t &second)
+{
+	if (!is_int_imm(first.opcode))
+		return false;
+	if (is_branch(second.opcode) && second.opcode != JUMP)
+		return second.src1 == first.dest;
+	if (second.opcode == LW || second.opcode == LWS)
+		return second.src1 == first.dest;
+	return false;
 }
 
 /* clears a ROB entry */
@@ -100,34 +150,62 @@ void clean_rob(rob_entry_t *entry)
 {
 	entry->ready = false;
 	entry->pc = UNDEFINED;
+	entry->thread = 0;
 	entry->state = ISSUE;
 	entry->destination = UNDEFINED;
 	entry->value = UNDEFINED;
 	entry->store_bypassed = false;
+	entry->phys_dest = UNDEFINED;
+	entry->blocked_commit = false;
 }
 
 /* clears a reservation station */
 void clean_res_station(res_station_entry_t *entry)
 {
 	entry->pc = UNDEFINED;
+	entry->thread = 0;
 	entry->value1 = UNDEFINED;
 	entry->value2 = UNDEFINED;
-	entry->tag1 = UNDEFINED;
-	entry->tag2 = UNDEFINED;
+	entry->value3 = UNDEFINED;
 	entry->destination = UNDEFINED;
 	entry->address = UNDEFINED;
+	entry->fused_destination = UNDEFINED;
+	for (unsigned l = 0; l < VECTOR_LANES; l++)
+	{
+		entry->vector1[l] = UNDEFINED;
+		entry->vector2[l] = UNDEFINED;
+	}
 }
 
 /* clears an entry if the instruction window */
 void clean_instr_window(instr_window_entry_t *entry)
 {
 	entry->pc = UNDEFINED;
+	entry->thread = 0;
 	entry->issue = UNDEFINED;
 	entry->exe = UNDEFINED;
 	entry->wr = UNDEFINED;
 	entry->commit = UNDEFINED;
 }
 
+/* returns the type of execution unit used by the opcode */
+exe_unit_t unit_for(opcode_t opcode)
+{
+	if (is_memory(opcode))
+		return MEMORY;
+	if (opcode == ADDS || opcode == SUBS)
+		return ADDER;
+	if (opcode == MULT || opcode == MULTS)
+		return MULTIPLIER;
+	if (opcode == DIV || opcode == DIVS)
+		return DIVIDER;
+	if (is_vector_alu(opcode))
+		return VECTOR;
+	if (opcode == FMAS)
+		return FMA;
+	return INTEGER;
+}
+
 /* implements the ALU operation 
    NOTE: this function does not cover LOADS and STORES!
 */
@@ -192,12 +270,144 @@ unsigned alu(opcode_t opcode, unsigned value1, unsigned value2, unsigned immedia
 	return result;
 }
 
+/* implements the fused multiply-add value1 * value2 + value3 (FMAS), with a single rounding */
+unsigned fma_alu(unsigned value1, unsigned value2, unsigned value3)
+{
+	return float2unsigned(fmaf(unsigned2float(value1), unsigned2float(value2), unsigned2float(value3)));
+}
+
+/* implements the ALU operation of a vector instruction lane by lane, with the corresponding scalar operation */
+void vector_alu(opcode_t opcode, const unsigned *vector1, const unsigned *vector2, unsigned *result)
+{
+	opcode_t scalar = opcode == ADDV ? ADDS : (opcode == SUBV ? SUBS : MULTS);
+	for (unsigned l = 0; l < VECTOR_LANES; l++)
+		result[l] = alu(scalar, vector1[l], vector2[l], 0, 0);
+}
+
+/* true if the memory accesses of two loads/stores overlap (scalar accesses are compared by address) */
+bool accesses_overlap(opcode_t opcode1, unsigned address1, opcode_t opcode2, unsigned address2)
+{
+	if (!is_vector(opcode1) && !is_vector(opcode2))
+		return address1 == address2;
+	unsigned size1 = is_vector(opcode1) ? 4 * VECTOR_LANES : 4;
+	unsigned size2 = is_vector(opcode2) ? 4 * VECTOR_LANES : 4;
+	return address1 < address2 + size2 && address2 < address1 + size1;
+}
+
 /* writes the data memory at the specified address */
 void sim_ooo::write_memory(unsigned address, unsigned value)
 {
 	unsigned2char(value, data_memory + address);
 }
 
+unsigned sim_ooo::read_memory(unsigned address)
+{
+	return char2unsigned(data_memory + address);
+}
+
+unsigned sim_ooo::load_word(unsigned address)
+{
+	unsigned value;
+	if (hierarchy != NULL && hierarchy->load(core_id, address, &value))
+		return value;
+	return char2unsigned(data_memory + address);
+}
+
+void sim_ooo::store_word(unsigned address, unsigned value)
+{
+	if (hierarchy == NULL || !hierarchy->store(core_id, address, value, clock_cycles))
+		unsigned2char(value, data_memory + address);
+}
+
+/* the private data memory is an anonymous mapping, so that memory images can be mapped over it */
+static unsigned char *allocate_memory(unsigned size)
+{
+	void *memory = mmap(NULL, size ? size : 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		cerr << "error: cannot allocate " << size << " bytes of data memory!" << endl;
+		exit(-1);
+	}
+	return (unsigned char *)memory;
+}
+
+static void free_memory(unsigned char *memory, unsigned size)
+{
+	munmap(memory, size ? size : 1);
+}
+
+bool sim_ooo::load_memory_image(const char *filename, unsigned base_address)
+{
+	int fd = open(filename, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		if (fd >= 0)
+			close(fd);
+		return load_failed("open file " + string(filename) + " failed");
+	}
+	unsigned long long size = st.st_size;
+	if (base_address + size > data_memory_size)
+	{
+		close(fd);
+		stringstream message;
+		message << "memory image " << filename << " does not fit in data memory at 0x" << hex << base_address;
+		return load_failed(message.str());
+	}
+
+	//whole pages are mapped copy-on-write over the private memory if the image starts on a page boundary
+	unsigned long long page = sysconf(_SC_PAGESIZE);
+	unsigned long long mapped = 0;
+	if (owns_memory && (unsigned long long)(data_memory + base_address) % page == 0 && size >= page)
+	{
+		mapped = size / page * page;
+		if (mmap(data_memory + base_address, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+		{
+			close(fd);
+			return load_failed("mapping " + string(filename) + " failed");
+		}
+	}
+	//the rest is copied
+	if (mapped < size)
+	{
+		void *image = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (image == MAP_FAILED)
+		{
+			close(fd);
+			return load_failed("mapping " + string(filename) + " failed");
+		}
+		memcpy(data_memory + base_address + mapped, (unsigned char *)image + mapped, size - mapped);
+		munmap(image, size);
+	}
+	close(fd);
+	return true;
+}
+
+void sim_ooo::dump_memory_image(const char *filename, unsigned start_address, unsigned end_address)
+{
+	if (start_address > end_address || end_address > data_memory_size)
+	{
+		cerr << "error: invalid memory range for image " << filename << "!" << endl;
+		exit(-1);
+	}
+	//the image is written aside and renamed into place: the file may be the one mapped under the data memory
+	string temporary = string(filename) + ".tmp";
+	ofstream out(temporary.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!out.is_open())
+	{
+		cerr << "error: open file " << temporary << " failed!" << endl;
+		exit(-1);
+	}
+	out.write((const char *)data_memory + start_address, end_address - start_address);
+	out.close();
+	if (out.fail() || rename(temporary.c_str(), filename) != 0)
+	{
+		remove(temporary.c_str());
+		cerr << "error: write file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+}
+
 /* =============================================================
 
    Handling of FUNCTIONAL UNITS
@@ -207,12 +417,18 @@ void sim_ooo::write_memory(unsigned address, unsigned value)
 /* initializes an execution unit */
 void sim_ooo::init_exec_unit(exe_unit_t exec_unit, unsigned latency, unsigned instances)
 {
+	if (instances > MAX_UNITS - num_units)
+	{
+		cerr << "error: the processor cannot have more than " << MAX_UNITS << " execution units!" << endl;
+		exit(-1);
+	}
 	for (unsigned i = 0; i < instances; i++)
 	{
 		exec_units[num_units].type = exec_unit;
 		exec_units[num_units].latency = latency;
 		exec_units[num_units].busy = 0;
 		exec_units[num_units].pc = UNDEFINED;
+		exec_units[num_units].thread = 0;
 		num_units++;
 	}
 }
@@ -251,6 +467,8 @@ unsigned sim_ooo::get_free_unit(opcode_t opcode)
 		case SW:
 		case LWS:
 		case SWS:
+		case LWV:
+		case SWV:
 			if (exec_units[u].type == MEMORY && exec_units[u].busy == 0 && exec_units[u].pc == UNDEFINED)
 				return u;
 			break;
@@ -272,6 +490,18 @@ unsigned sim_ooo::get_free_unit(opcode_t opcode)
 			if (exec_units[u].type == DIVIDER && exec_units[u].busy == 0 && exec_units[u].pc == UNDEFINED)
 				return u;
 			break;
+		// FMA unit
+		case FMAS:
+			if (exec_units[u].type == FMA && exec_units[u].busy == 0 && exec_units[u].pc == UNDEFINED)
+				return u;
+			break;
+		// Vector unit
+		case ADDV:
+		case SUBV:
+		case MULV:
+			if (exec_units[u].type == VECTOR && exec_units[u].busy == 0 && exec_units[u].pc == UNDEFINED)
+				return u;
+			break;
 		default:
 			cout << "ERROR:: operations not requiring exec unit!\n";
 			exit(-1);
@@ -312,23 +542,41 @@ void sim_ooo::print_memory(unsigned start_address, unsigned end_address)
 void sim_ooo::print_registers()
 {
 	unsigned i;
-	cout << "GENERAL PURPOSE REGISTERS" << endl;
-	cout << setfill(' ') << setw(8) << "Register" << setw(22) << "Value" << setw(5) << "ROB" << endl;
-	for (i = 0; i < NUM_GP_REGISTERS; i++)
-	{
-		if (get_int_register_tag(i) != UNDEFINED)
-			cout << setfill(' ') << setw(7) << "R" << dec << i << setw(22) << "-" << setw(5) << get_int_register_tag(i) << endl;
-		else if (get_int_register(i) != (int)UNDEFINED)
-			cout << setfill(' ') << setw(7) << "R" << dec << i << setw(11) << get_int_register(i) << hex << "/0x" << setw(8) << setfill('0') << get_int_register(i) << setfill(' ') << setw(5) << "-" << endl;
-	}
-	for (i = 0; i < NUM_GP_REGISTERS; i++)
+	for (unsigned t = 0; t < num_threads; t++)
 	{
-		if (get_fp_register_tag(i) != UNDEFINED)
-			cout << setfill(' ') << setw(7) << "F" << dec << i << setw(22) << "-" << setw(5) << get_fp_register_tag(i) << endl;
-		else if (get_fp_register(i) != UNDEFINED)
-			cout << setfill(' ') << setw(7) << "F" << dec << i << setw(11) << get_fp_register(i) << hex << "/0x" << setw(8) << setfill('0') << float2unsigned(get_fp_register(i)) << setfill(' ') << setw(5) << "-" << endl;
+		cout << "GENERAL PURPOSE REGISTERS";
+		if (num_threads > 1)
+			cout << " (THREAD " << dec << t << ")";
+		cout << endl;
+		cout << setfill(' ') << setw(8) << "Register" << setw(22) << "Value" << setw(5) << "ROB" << endl;
+		for (i = 0; i < NUM_GP_REGISTERS; i++)
+		{
+			if (get_int_register_tag(i, t) != UNDEFINED)
+				cout << setfill(' ') << setw(7) << "R" << dec << i << setw(22) << "-" << setw(5) << get_int_register_tag(i, t) << endl;
+			else if (get_int_register(i, t) != (int)UNDEFINED)
+				cout << setfill(' ') << setw(7) << "R" << dec << i << setw(11) << get_int_register(i, t) << hex << "/0x" << setw(8) << setfill('0') << get_int_register(i, t) << setfill(' ') << setw(5) << "-" << endl;
+		}
+		for (i = 0; i < NUM_GP_REGISTERS; i++)
+		{
+			if (get_fp_register_tag(i, t) != UNDEFINED)
+				cout << setfill(' ') << setw(7) << "F" << dec << i << setw(22) << "-" << setw(5) << get_fp_register_tag(i, t) << endl;
+			else if (get_fp_register(i, t) != UNDEFINED)
+				cout << setfill(' ') << setw(7) << "F" << dec << i << setw(11) << get_fp_register(i, t) << hex << "/0x" << setw(8) << setfill('0') << float2unsigned(get_fp_register(i, t)) << setfill(' ') << setw(5) << "-" << endl;
+		}
+		for (i = 0; i < NUM_GP_REGISTERS; i++)
+		{
+			if (get_vector_register_tag(i, t) != UNDEFINED)
+				cout << setfill(' ') << setw(7) << "V" << dec << i << setw(22) << "-" << setw(5) << get_vector_register_tag(i, t) << endl;
+			else if (get_vector_register(i, 0, t) != UNDEFINED)
+			{
+				cout << setfill(' ') << setw(7) << "V" << dec << i;
+				for (unsigned l = 0; l < VECTOR_LANES; l++)
+					cout << setw(11) << get_vector_register(i, l, t);
+				cout << endl;
+			}
+		}
+		cout << endl;
 	}
-	cout << endl;
 }
 
 /* prints the content of the ROB */
@@ -341,7 +589,7 @@ void sim_ooo::print_rob()
 		rob_entry_t entry = rob.entries[i];
 		instruction_t instruction;
 		if (entry.pc != UNDEFINED)
-			instruction = instr_memory[(entry.pc - instr_base_address) >> 2];
+			instruction = instruction_of(entry.thread, entry.pc);
 		cout << setfill(' ');
 		cout << setw(5) << i;
 		cout << setw(6);
@@ -367,14 +615,18 @@ void sim_ooo::print_rob()
 			cout << setw(6) << "-";
 		else
 		{
-			if (instruction.opcode == SW || instruction.opcode == SWS)
+			if (instruction.opcode == SW || is_store(instruction.opcode))
 				cout << setw(6) << dec << entry.destination;
 			else if (entry.destination < NUM_GP_REGISTERS)
 				cout << setw(5) << "R" << dec << entry.destination;
-			else
+			else if (entry.destination < 2 * NUM_GP_REGISTERS)
 				cout << setw(5) << "F" << dec << entry.destination - NUM_GP_REGISTERS;
+			else
+				cout << setw(5) << "V" << dec << entry.destination - 2 * NUM_GP_REGISTERS;
 		}
-		if (entry.value != UNDEFINED)
+		if (entry.phys_dest != UNDEFINED)
+			cout << setw(11) << (entry.destination < NUM_GP_REGISTERS ? "P" : "FP") << dec << entry.phys_dest << endl;
+		else if (entry.value != UNDEFINED)
 			cout << "  0x" << hex << setw(8) << setfill('0') << entry.value << endl;
 		else
 			cout << setw(12) << setfill(' ') << "-" << endl;
@@ -414,13 +666,13 @@ void sim_ooo::print_reservation_stations()
 			cout << setfill(' ') << setw(12) << "-";
 		cout << setfill(' ');
 		cout << setw(6);
-		if (entry.tag1 != UNDEFINED)
-			cout << dec << entry.tag1;
+		if (rs_tags[0][i] != NO_TAG)
+			cout << dec << rs_tags[0][i];
 		else
 			cout << "-";
 		cout << setw(6);
-		if (entry.tag2 != UNDEFINED)
-			cout << dec << entry.tag2;
+		if (rs_tags[1][i] != NO_TAG)
+			cout << dec << rs_tags[1][i];
 		else
 			cout << "-";
 		cout << setw(6);
@@ -443,6 +695,8 @@ void sim_ooo::print_pending_instructions()
 	cout << "PENDING INSTRUCTIONS STATUS" << endl;
 	cout << setfill(' ');
 	cout << setw(10) << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit";
+	if (num_threads > 1)
+		cout << setw(8) << "Thread";
 	cout << endl;
 	for (unsigned i = 0; i < pending_instructions.num_entries; i++)
 	{
@@ -472,6 +726,8 @@ void sim_ooo::print_pending_instructions()
 			cout << dec << entry.commit;
 		else
 			cout << "-";
+		if (num_threads > 1 && entry.pc != UNDEFINED)
+			cout << setw(8) << dec << entry.thread;
 		cout << endl;
 	}
 	cout << endl;
@@ -483,12 +739,18 @@ void sim_ooo::init_log()
 	log << "EXECUTION LOG" << endl;
 	log << setfill(' ');
 	log << setw(10) << "PC" << setw(7) << "Issue" << setw(7) << "Exe" << setw(7) << "WR" << setw(7) << "Commit";
+	if (num_threads > 1)
+		log << setw(8) << "Thread";
 	log << endl;
 }
 
 /* adds an instruction to the log */
 void sim_ooo::commit_to_log(instr_window_entry_t entry)
 {
+	if (histograms_enabled)
+		record_latencies(entry);
+	if (profiler_enabled && entry.pc != UNDEFINED && entry.commit != UNDEFINED)
+		profile_of(entry.thread, entry.pc).executed++;
 	if (entry.pc != UNDEFINED)
 		log << "0x" << setfill('0') << setw(8) << hex << entry.pc;
 	else
@@ -514,6 +776,8 @@ void sim_ooo::commit_to_log(instr_window_entry_t entry)
 		log << dec << entry.commit;
 	else
 		log << "-";
+	if (num_threads > 1)
+		log << setw(8) << dec << entry.thread;
 	log << endl;
 }
 
@@ -532,214 +796,2034 @@ void sim_ooo::print_status()
 	print_registers();
 }
 
-/* execution statistics */
-
-float sim_ooo::get_IPC() { return (float)instructions_executed / clock_cycles; }
-
-unsigned sim_ooo::get_instructions_executed() { return instructions_executed; }
-
-unsigned sim_ooo::get_clock_cycles() { return clock_cycles; }
-
 /* ============================================================================
 
-   PARSER
+   Occupancy and latency histograms
 
    =========================================================================== */
 
-void sim_ooo::load_program(const char *filename, unsigned base_address)
+void sim_ooo::enable_histograms(bool enable)
 {
+	histograms_enabled = enable;
+}
 
-	/* initializing the base instruction address */
-	instr_base_address = base_address;
-	PC = base_address;
+/* samples how many entries of each structure are in use in the current clock cycle */
+void sim_ooo::sample_histograms()
+{
+	unsigned rob_busy = 0;
+	unsigned rs_busy[NUM_RS_TYPES] = {0};
+	unsigned units_busy[NUM_UNIT_TYPES] = {0};
+	for (unsigned i = 0; i < rob.num_entries; i++)
+		if (rob.entries[i].pc != UNDEFINED)
+			rob_busy++;
+	for (unsigned i = 0; i < reservation_stations.num_entries; i++)
+		if (reservation_stations.entries[i].pc != UNDEFINED)
+			rs_busy[reservation_stations.entries[i].type]++;
+	for (unsigned u = 0; u < num_units; u++)
+		if (exec_units[u].pc != UNDEFINED)
+			units_busy[exec_units[u].type]++;
+	rob_occupancy[rob_busy]++;
+	for (unsigned t = 0; t < NUM_RS_TYPES; t++)
+		rs_occupancy[t][rs_busy[t]]++;
+	for (unsigned t = 0; t < NUM_UNIT_TYPES; t++)
+		unit_occupancy[t][units_busy[t]]++;
+}
 
-	/* creating a map with the valid opcodes and with the valid labels */
-	map<string, opcode_t> opcodes; //for opcodes
-	map<string, unsigned> labels;  //for branches
-	for (int i = 0; i < NUM_OPCODES; i++)
-		opcodes[string(instr_names[i])] = (opcode_t)i;
+/* records issue-to-execute and execute-to-commit latencies (squashed instructions are ignored) */
+void sim_ooo::record_latencies(instr_window_entry_t entry)
+{
+	if (entry.pc == UNDEFINED || entry.exe == UNDEFINED || entry.commit == UNDEFINED)
+		return;
+	opcode_t opcode = instruction_of(entry.thread, entry.pc).opcode;
+	issue_to_exe_latency[opcode][entry.exe - entry.issue]++;
+	exe_to_commit_latency[opcode][entry.commit - entry.exe]++;
+}
 
-	/* opening the assembly file */
-	ifstream fin(filename, ios::in | ios::binary);
-	if (!fin.is_open())
+/* prints a histogram as a JSON object */
+static void histogram_to_json(ofstream &out, histogram_t &histogram)
+{
+	out << "{";
+	for (histogram_t::iterator it = histogram.begin(); it != histogram.end(); it++)
 	{
-		cerr << "error: open file " << filename << " failed!" << endl;
-		exit(-1);
+		if (it != histogram.begin())
+			out << ", ";
+		out << "\"" << it->first << "\": " << it->second;
 	}
+	out << "}";
+}
 
-	/* parsing the assembly file line by line */
-	string line;
-	unsigned instruction_nr = 0;
-	while (getline(fin, line))
+/* prints a set of histograms as a JSON object, skipping the empty ones */
+static void histograms_to_json(ofstream &out, histogram_t *histograms, const char **names, unsigned num)
+{
+	bool first = true;
+	out << "{";
+	for (unsigned i = 0; i < num; i++)
 	{
+		if (histograms[i].empty())
+			continue;
+		if (!first)
+			out << ",";
+		out << endl
+			<< "      \"" << names[i] << "\": ";
+		histogram_to_json(out, histograms[i]);
+		first = false;
+	}
+	out << endl
+		<< "    }";
+}
 
-		// set the instruction field
-		char *str = const_cast<char *>(line.c_str());
+void sim_ooo::dump_histograms(const char *filename)
+{
+	ofstream out(filename);
+	if (!out.is_open())
+	{
+		cerr << "error: open file " << filename << " failed!" << endl;
+		return;
+	}
+	out << "{" << endl;
+	out << "  \"clock_cycles\": " << dec << clock_cycles << "," << endl;
+	out << "  \"instructions_executed\": " << instructions_executed << "," << endl;
+	out << "  \"occupancy\": {" << endl;
+	out << "    \"rob\": ";
+	histogram_to_json(out, rob_occupancy);
+	out << "," << endl
+		<< "    \"reservation_stations\": ";
+	histograms_to_json(out, rs_occupancy, res_station_names, NUM_RS_TYPES);
+	out << "," << endl
+		<< "    \"exec_units\": ";
+	histograms_to_json(out, unit_occupancy, unit_names, NUM_UNIT_TYPES);
+	out << endl
+		<< "  }," << endl;
+	out << "  \"latency\": {" << endl;
+	out << "    \"issue_to_execute\": ";
+	histograms_to_json(out, issue_to_exe_latency, instr_names, NUM_OPCODES);
+	out << "," << endl
+		<< "    \"execute_to_commit\": ";
+	histograms_to_json(out, exe_to_commit_latency, instr_names, NUM_OPCODES);
+	out << endl
+		<< "  }" << endl;
+	out << "}" << endl;
+}
 
-		// tokenize the instruction
-		char *token = strtok(str, " \t");
-		map<string, opcode_t>::iterator search = opcodes.find(token);
-		if (search == opcodes.end())
-		{
-			// this is a label for a branch - extract it and save it in the labels map
-			string label = string(token).substr(0, string(token).length() - 1);
-			labels[label] = instruction_nr;
-			// move to next token, which must be the instruction opcode
-			token = strtok(NULL, " \t");
-			search = opcodes.find(token);
-			if (search == opcodes.end())
-				cout << "ERROR: invalid opcode: " << token << " !" << endl;
-		}
+/* ============================================================================
 
-		instr_memory[instruction_nr].opcode = search->second;
+   Per-PC hotspot profiler
 
-		//reading remaining parameters
-		char *par1;
-		char *par2;
-		char *par3;
-		switch (instr_memory[instruction_nr].opcode)
+   =========================================================================== */
+
+void sim_ooo::enable_profiler(bool enable)
+{
+	profiler_enabled = enable;
+}
+
+/* charges the current clock cycle to the instructions in flight and to the instruction stalled at issue */
+void sim_ooo::sample_profile()
+{
+	if (issue_struct_stall)
+		profile_of(issue_thread, issue_stall_pc).stalls[issue_stall_cause]++;
+	for (unsigned i = 0; i < rob.num_entries; i++)
+	{
+		rob_entry_t entry = rob.entries[i];
+		if (entry.pc == UNDEFINED)
+			continue;
+		pc_profile_t *prof = &profile_of(entry.thread, entry.pc);
+		prof->cycles[entry.state]++;
+		if (entry.state != ISSUE || pending_instructions.entries[i].issue == clock_cycles)
+			continue;
+		// the instruction could have started executing in this cycle: find out why it did not
+		for (unsigned j = 0; j < reservation_stations.num_entries; j++)
 		{
-		case ADD:
-		case SUB:
-		case XOR:
-		case AND:
-		case MULT:
-		case DIV:
-		case ADDS:
-		case SUBS:
-		case MULTS:
-		case DIVS:
-			par1 = strtok(NULL, " \t");
-			par2 = strtok(NULL, " \t");
-			par3 = strtok(NULL, " \t");
-			instr_memory[instruction_nr].dest = atoi(strtok(par1, "RF"));
-			instr_memory[instruction_nr].src1 = atoi(strtok(par2, "RF"));
-			instr_memory[instruction_nr].src2 = atoi(strtok(par3, "RF"));
-			break;
-		case ADDI:
-		case SUBI:
-			par1 = strtok(NULL, " \t");
-			par2 = strtok(NULL, " \t");
-			par3 = strtok(NULL, " \t");
-			instr_memory[instruction_nr].dest = atoi(strtok(par1, "R"));
-			instr_memory[instruction_nr].src1 = atoi(strtok(par2, "R"));
-			instr_memory[instruction_nr].immediate = strtoul(par3, NULL, 0);
-			break;
-		case LW:
-		case LWS:
-			par1 = strtok(NULL, " \t");
-			par2 = strtok(NULL, " \t");
-			instr_memory[instruction_nr].dest = atoi(strtok(par1, "RF"));
-			instr_memory[instruction_nr].immediate = strtoul(strtok(par2, "()"), NULL, 0);
-			instr_memory[instruction_nr].src1 = atoi(strtok(NULL, "R"));
-			break;
-		case SW:
-		case SWS:
-			par1 = strtok(NULL, " \t");
-			par2 = strtok(NULL, " \t");
-			instr_memory[instruction_nr].src1 = atoi(strtok(par1, "RF"));
-			instr_memory[instruction_nr].immediate = strtoul(strtok(par2, "()"), NULL, 0);
-			instr_memory[instruction_nr].src2 = atoi(strtok(NULL, "R"));
-			break;
-		case BEQZ:
-		case BNEZ:
-		case BLTZ:
-		case BGTZ:
-		case BLEZ:
-		case BGEZ:
-			par1 = strtok(NULL, " \t");
-			par2 = strtok(NULL, " \t");
-			instr_memory[instruction_nr].src1 = atoi(strtok(par1, "R"));
-			instr_memory[instruction_nr].label = par2;
-			break;
-		case JUMP:
-			par2 = strtok(NULL, " \t");
-			instr_memory[instruction_nr].label = par2;
-		default:
+			res_station_entry_t rs = reservation_stations.entries[j];
+			if (rs.pc != entry.pc || rs.destination != i)
+				continue;
+			opcode_t opcode = instruction_of(entry.thread, entry.pc).opcode;
+			if (rs_tags[0][j] != NO_TAG || rs_tags[1][j] != NO_TAG || rs_tags[2][j] != NO_TAG)
+				prof->stalls[STALL_OPERANDS]++;
+			else if (is_load(opcode) && get_free_unit(opcode) != UNDEFINED)
+				prof->stalls[STALL_MEMORY]++;
+			else
+				prof->stalls[STALL_UNIT]++;
 			break;
 		}
-
-		/* increment instruction number before moving to next line */
-		instruction_nr++;
 	}
-	//reconstructing the labels of the branch operations
-	int i = 0;
-	while (true)
+}
+
+/* orders (cycles, index) pairs by decreasing number of cycles */
+static bool greater_first(const pair<unsigned long long, unsigned> &a, const pair<unsigned long long, unsigned> &b)
+{
+	return a.first > b.first;
+}
+
+/* total number of cycles charged to a static instruction */
+static unsigned long long profile_cycles(const pc_profile_t &prof)
+{
+	unsigned long long total = 0;
+	for (unsigned s = 0; s < NUM_STAGES; s++)
+		total += prof.cycles[s];
+	for (unsigned c = 0; c < NUM_STALL_CAUSES; c++)
+		if (c == STALL_ROB_FULL || c == STALL_RS_FULL || c == STALL_PRF_FULL || c == STALL_FETCH)
+			total += prof.stalls[c];
+	return total;
+}
+
+void sim_ooo::print_profile()
+{
+	for (unsigned t = 0; t < num_threads; t++)
 	{
-		instruction_t instr = instr_memory[i];
-		if (instr.opcode == EOP)
-			break;
-		if (instr.opcode == BLTZ || instr.opcode == BNEZ ||
-			instr.opcode == BGTZ || instr.opcode == BEQZ ||
-			instr.opcode == BGEZ || instr.opcode == BLEZ ||
-			instr.opcode == JUMP)
+		hw_context_t *ctx = &contexts[t];
+		vector<pair<unsigned long long, unsigned> > order;
+		unsigned long long total = 0;
+		for (unsigned i = 0; i < ctx->num_instructions; i++)
 		{
-			instr_memory[i].immediate = (labels[instr.label] - i - 1) << 2;
+			unsigned long long cycles = profile_cycles(ctx->profile[i]);
+			order.push_back(make_pair(cycles, i));
+			total += cycles;
 		}
-		i++;
+		// stable sort, so that instructions with the same contribution stay in program order
+		stable_sort(order.begin(), order.end(), greater_first);
+
+		cout << "PROFILE";
+		if (num_threads > 1)
+			cout << " (THREAD " << dec << t << ")";
+		cout << endl;
+		cout << setfill(' ') << setw(10) << "PC" << setw(8) << "Count" << setw(8) << "Cycles" << setw(7) << "%";
+		for (unsigned s = 0; s < NUM_STAGES; s++)
+			cout << setw(7) << stage_names[s];
+		for (unsigned c = 0; c < NUM_STALL_CAUSES; c++)
+			cout << setw(6) << stall_names[c];
+		cout << setw(8) << "Mispr" << setw(8) << "Flush" << "  Source" << endl;
+		for (unsigned k = 0; k < order.size(); k++)
+		{
+			unsigned i = order[k].second;
+			pc_profile_t prof = ctx->profile[i];
+			cout << "0x" << hex << setfill('0') << setw(8) << ctx->instr_base_address + (i << 2) << setfill(' ') << dec;
+			cout << setw(8) << prof.executed << setw(8) << order[k].first;
+			cout << setw(7) << fixed << setprecision(1) << (total ? 100.0 * order[k].first / total : 0.0);
+			cout.unsetf(ios::floatfield);
+			for (unsigned s = 0; s < NUM_STAGES; s++)
+				cout << setw(7) << prof.cycles[s];
+			for (unsigned c = 0; c < NUM_STALL_CAUSES; c++)
+				cout << setw(6) << prof.stalls[c];
+			cout << setw(8) << prof.mispredictions << setw(8) << prof.flushed << "  ";
+			// expand tabs, so that labels and instructions line up as in the source file
+			string line = ctx->source_lines[i];
+			line = line.substr(0, line.find_last_not_of(" \t\r\n") + 1);
+			unsigned col = 0;
+			for (unsigned c = 0; c < line.length(); c++)
+			{
+				if (line[c] == '\t')
+					do
+						cout << ' ';
+					while (++col % 8);
+				else
+				{
+					cout << line[c];
+					col++;
+				}
+			}
+			cout << endl;
+		}
+		cout << endl;
 	}
 }
 
 /* ============================================================================
 
-   Simulator creation, initialization and deallocation 
+   Dataflow limit analysis
 
    =========================================================================== */
 
-sim_ooo::sim_ooo(unsigned mem_size,
-				 unsigned rob_size,
-				 unsigned num_int_res_stations,
-				 unsigned num_add_res_stations,
-				 unsigned num_mul_res_stations,
-				 unsigned num_load_res_stations,
-				 unsigned max_issue)
+dataflow_limit_t sim_ooo::get_dataflow_limit(unsigned long long max_instructions, unsigned thread)
 {
-	//memory
-	data_memory_size = mem_size;
-	data_memory = new unsigned char[data_memory_size];
+	dataflow_limit_t limit = {0, 0, 0};
+	hw_context_t *ctx = &contexts[thread];
 
-	//issue width
-	issue_width = max_issue;
+	//latency of each unit type (1 if the processor does not have a unit of that type)
+	unsigned latency[NUM_UNIT_TYPES];
+	for (unsigned t = 0; t < NUM_UNIT_TYPES; t++)
+		latency[t] = 1;
+	for (unsigned u = num_units; u > 0; u--)
+		latency[exec_units[u - 1].type] = exec_units[u - 1].latency;
+
+	//architectural state used by the functional execution: registers are copied, stores go to an overlay
+	unsigned int_val[NUM_GP_REGISTERS], fp_val[NUM_GP_REGISTERS], v_val[NUM_GP_REGISTERS][VECTOR_LANES];
+	for (unsigned r = 0; r < NUM_GP_REGISTERS; r++)
+	{
+		int_val[r] = ctx->INT_regs[r];
+		fp_val[r] = float2unsigned(ctx->FP_regs[r]);
+		for (unsigned l = 0; l < VECTOR_LANES; l++)
+			v_val[r][l] = float2unsigned(ctx->V_regs[r][l]);
+	}
+	map<unsigned, unsigned> stored;
+
+	//clock cycle in which each value becomes available, with unit latencies ([0]) and with the unit latencies ([1])
+	unsigned long long int_ready[2][NUM_GP_REGISTERS], fp_ready[2][NUM_GP_REGISTERS], v_ready[2][NUM_GP_REGISTERS];
+	memset(int_ready, 0, sizeof(int_ready));
+	memset(fp_ready, 0, sizeof(fp_ready));
+	memset(v_ready, 0, sizeof(v_ready));
+	map<unsigned, unsigned long long> mem_ready[2];
+
+	unsigned pc = ctx->instr_base_address;
+	while (max_instructions == 0 || limit.instructions < max_instructions)
+	{
+		unsigned index = (pc - ctx->instr_base_address) >> 2;
+		if (index >= PROGRAM_SIZE)
+			break;
+		instruction_t instr = ctx->instr_memory[index];
+		if (instr.opcode == EOP)
+			break;
+		unsigned next_pc = pc + 4;
+		unsigned lat[2] = {1, latency[unit_for(instr.opcode)]};
+		for (unsigned m = 0; m < 2; m++)
+		{
+			unsigned long long start = 0, done;
+			switch (instr.opcode)
+			{
+			case LW:
+			case LWS:
+			{
+				unsigned address = int_val[instr.src1] + instr.immediate;
+				start = int_ready[m][instr.src1];
+				if (mem_ready[m].count(address))
+					start = max(start, mem_ready[m][address]);
+				done = start + lat[m];
+				if (instr.opcode == LW)
+					int_ready[m][instr.dest] = done;
+				else
+					fp_ready[m][instr.dest] = done;
+				break;
+			}
+			case SW:
+			case SWS:
+				start = max(instr.opcode == SW ? int_ready[m][instr.src1] : fp_ready[m][instr.src1], int_ready[m][instr.src2]);
+				done = start + lat[m];
+				mem_ready[m][int_val[instr.src2] + instr.immediate] = done;
+				break;
+			case LWV:
+			{
+				unsigned address = int_val[instr.src1] + instr.immediate;
+				start = int_ready[m][instr.src1];
+				for (unsigned l = 0; l < VECTOR_LANES; l++)
+					if (mem_ready[m].count(address + 4 * l))
+						start = max(start, mem_ready[m][address + 4 * l]);
+				done = start + lat[m];
+				v_ready[m][instr.dest] = done;
+				break;
+			}
+			case SWV:
+				start = max(v_ready[m][instr.src1], int_ready[m][instr.src2]);
+				done = start + lat[m];
+				for (unsigned l = 0; l < VECTOR_LANES; l++)
+					mem_ready[m][int_val[instr.src2] + instr.immediate + 4 * l] = done;
+				break;
+			case FMAS:
+				start = max(max(fp_ready[m][instr.src1], fp_ready[m][instr.src2]), fp_ready[m][instr.src3]);
+				done = start + lat[m];
+				fp_ready[m][instr.dest] = done;
+				break;
+			case ADDV:
+			case SUBV:
+			case MULV:
+				start = max(v_ready[m][instr.src1], v_ready[m][instr.src2]);
+				done = start + lat[m];
+				v_ready[m][instr.dest] = done;
+				break;
+			case ADDS:
+			case SUBS:
+			case MULTS:
+			case DIVS:
+				start = max(fp_ready[m][instr.src1], fp_ready[m][instr.src2]);
+				done = start + lat[m];
+				fp_ready[m][instr.dest] = done;
+				break;
+			case ADDI:
+			case SUBI:
+				start = int_ready[m][instr.src1];
+				done = start + lat[m];
+				int_ready[m][instr.dest] = done;
+				break;
+			case JUMP:
+				done = start + lat[m];
+				break;
+			default:
+				if (is_branch(instr.opcode))
+				{
+					start = int_ready[m][instr.src1];
+					done = start + lat[m];
+				}
+				else
+				{
+					start = max(int_ready[m][instr.src1], int_ready[m][instr.src2]);
+					done = start + lat[m];
+					int_ready[m][instr.dest] = done;
+				}
+				break;
+			}
+			if (m == 0)
+				limit.critical_path = max(limit.critical_path, done);
+			else
+				limit.critical_path_latency = max(limit.critical_path_latency, done);
+		}
+
+		//functional execution
+		switch (instr.opcode)
+		{
+		case LW:
+		case LWS:
+		{
+			unsigned address = int_val[instr.src1] + instr.immediate;
+			unsigned value;
+			if (stored.count(address))
+				value = stored[address];
+			else
+				value = (address + 4 <= data_memory_size) ? char2unsigned(&data_memory[address]) : UNDEFINED;
+			if (instr.opcode == LW)
+				int_val[instr.dest] = value;
+			else
+				fp_val[instr.dest] = value;
+			break;
+		}
+		case SW:
+			stored[int_val[instr.src2] + instr.immediate] = int_val[instr.src1];
+			break;
+		case SWS:
+			stored[int_val[instr.src2] + instr.immediate] = fp_val[instr.src1];
+			break;
+		case LWV:
+			for (unsigned l = 0; l < VECTOR_LANES; l++)
+			{
+				unsigned address = int_val[instr.src1] + instr.immediate + 4 * l;
+				if (stored.count(address))
+					v_val[instr.dest][l] = stored[address];
+				else
+					v_val[instr.dest][l] = (address + 4 <= data_memory_size) ? char2unsigned(&data_memory[address]) : UNDEFINED;
+			}
+			break;
+		case SWV:
+			for (unsigned l = 0; l < VECTOR_LANES; l++)
+				stored[int_val[instr.src2] + instr.immediate + 4 * l] = v_val[instr.src1][l];
+			break;
+		case FMAS:
+			fp_val[instr.dest] = fma_alu(fp_val[instr.src1], fp_val[instr.src2], fp_val[instr.src3]);
+			break;
+		case ADDV:
+		case SUBV:
+		case MULV:
+			vector_alu(instr.opcode, v_val[instr.src1], v_val[instr.src2], v_val[instr.dest]);
+			break;
+		case ADDS:
+		case SUBS:
+		case MULTS:
+		case DIVS:
+			fp_val[instr.dest] = alu(instr.opcode, fp_val[instr.src1], fp_val[instr.src2], instr.immediate, pc);
+			break;
+		case ADDI:
+		case SUBI:
+			int_val[instr.dest] = alu(instr.opcode, int_val[instr.src1], 0, instr.immediate, pc);
+			break;
+		case JUMP:
+			next_pc = alu(instr.opcode, 0, 0, instr.immediate, pc);
+			break;
+		default:
+			if (is_branch(instr.opcode))
+				next_pc = alu(instr.opcode, int_val[instr.src1], 0, instr.immediate, pc);
+			else
+				int_val[instr.dest] = alu(instr.opcode, int_val[instr.src1], int_val[instr.src2], instr.immediate, pc);
+			break;
+		}
+		limit.instructions++;
+		pc = next_pc;
+	}
+	return limit;
+}
+
+void sim_ooo::print_dataflow_limit(unsigned long long max_instructions, unsigned thread)
+{
+	dataflow_limit_t limit = get_dataflow_limit(max_instructions, thread);
+	cout << "DATAFLOW LIMIT" << endl;
+	cout << "Instructions = " << dec << limit.instructions << endl;
+	cout << "Critical path (unit latency) = " << limit.critical_path << " cycles, ideal IPC = " << (limit.critical_path ? (float)limit.instructions / limit.critical_path : 0) << endl;
+	cout << "Critical path (exec unit latencies) = " << limit.critical_path_latency << " cycles, ideal IPC = " << (limit.critical_path_latency ? (float)limit.instructions / limit.critical_path_latency : 0) << endl;
+	cout << endl;
+}
+
+/* execution statistics */
+
+float sim_ooo::get_IPC() { return (float)instructions_executed / clock_cycles; }
+
+unsigned sim_ooo::get_instructions_executed() { return instructions_executed; }
+
+unsigned sim_ooo::get_clock_cycles() { return clock_cycles; }
+
+float sim_ooo::get_thread_IPC(unsigned thread)
+{
+	unsigned cycles = thread_completed(thread) ? contexts[thread].last_commit_cycle + 1 : clock_cycles;
+	return (float)contexts[thread].instructions_executed / cycles;
+}
+
+unsigned sim_ooo::get_thread_instructions_executed(unsigned thread) { return contexts[thread].instructions_executed; }
+
+void sim_ooo::print_thread_stats()
+{
+	cout << "THREADS (fetch policy " << fetch_policy_names[fetch_policy] << ", " << (partitioned_rob ? "partitioned" : "shared") << " ROB)" << endl;
+	cout << setfill(' ') << setw(6) << "Thread" << setw(14) << "Instructions" << setw(10) << "Cycles" << setw(8) << "IPC" << endl;
+	streamsize precision = cout.precision();
+	for (unsigned t = 0; t < num_threads; t++)
+	{
+		unsigned cycles = thread_completed(t) ? contexts[t].last_commit_cycle + 1 : clock_cycles;
+		cout << setw(6) << dec << t << setw(14) << get_thread_instructions_executed(t) << setw(10) << cycles << setw(8) << fixed << setprecision(3) << get_thread_IPC(t) << endl;
+	}
+	cout << setw(6) << "all" << setw(14) << get_instructions_executed() << setw(10) << clock_cycles << setw(8) << get_IPC() << endl;
+	cout.unsetf(ios::floatfield);
+	cout.precision(precision);
+	cout << endl;
+}
+
+/* ============================================================================
+
+   PARSER
+
+   =========================================================================== */
+
+/* number of operands of an instruction in the assembly file */
+static unsigned num_operands(opcode_t opcode)
+{
+	if (opcode == FMAS)
+		return 4;
+	if (opcode == EOP)
+		return 0;
+	if (opcode == JUMP)
+		return 1;
+	if (is_memory(opcode) || (is_branch(opcode)))
+		return 2;
+	return 3;
+}
+
+/* number of tokens left in the line being parsed */
+static unsigned count_operands(const char *rest)
+{
+	unsigned count = 0;
+	while (rest != NULL && *rest != '\0')
+	{
+		rest += strspn(rest, " \t\r");
+		if (*rest == '\0')
+			break;
+		rest += strcspn(rest, " \t\r");
+		count++;
+	}
+	return count;
+}
+
+bool sim_ooo::load_failed(const string &message)
+{
+	if (exit_on_error)
+	{
+		cerr << "error: " << message << "!" << endl;
+		exit(-1);
+	}
+	load_error = message;
+	return false;
+}
+
+void sim_ooo::exit_on_load_error(bool exit) { exit_on_error = exit; }
+
+string sim_ooo::get_load_error() { return load_error; }
+
+bool sim_ooo::load_program(const char *filename, unsigned base_address, unsigned thread)
+{
+	hw_context_t *ctx = &contexts[thread];
+	instruction_t *instr_memory = ctx->instr_memory;
+
+	/* initializing the base instruction address */
+	ctx->instr_base_address = base_address;
+	ctx->PC = base_address;
+	ctx->fetch_pc = UNDEFINED;
+	ctx->fetch_count = 0;
+
+	/* creating a map with the valid opcodes and with the valid labels */
+	map<string, opcode_t> opcodes; //for opcodes
+	map<string, unsigned> labels;  //for branches
+	for (int i = 0; i < NUM_OPCODES; i++)
+		opcodes[string(instr_names[i])] = (opcode_t)i;
+	bool has_vector_res_stations = false;
+	for (unsigned i = 0; i < reservation_stations.num_entries; i++)
+		if (reservation_stations.entries[i].type == VECTOR_RS)
+			has_vector_res_stations = true;
+
+	/* opening the assembly file */
+	ifstream fin(filename, ios::in | ios::binary);
+	if (!fin.is_open())
+		return load_failed("open file " + string(filename) + " failed");
+
+	/* parsing the assembly file line by line */
+	string line;
+	unsigned instruction_nr = 0;
+	while (getline(fin, line))
+	{
+
+		// keep the source line for the profiler listing
+		string source = line;
+
+		// set the instruction field
+		char *str = const_cast<char *>(line.c_str());
+
+		// tokenize the instruction (skipping empty lines); strtok_r, so that several simulators can load programs concurrently
+		char *save;
+		char *token = strtok_r(str, " \t\r", &save);
+		if (token == NULL)
+			continue;
+		if (instruction_nr == PROGRAM_SIZE - 1)
+		{
+			stringstream message;
+			message << "program " << filename << " exceeds " << PROGRAM_SIZE - 1 << " instructions";
+			return load_failed(message.str());
+		}
+		map<string, opcode_t>::iterator search = opcodes.find(token);
+		if (search == opcodes.end())
+		{
+			if (token[strlen(token) - 1] != ':')
+				return load_failed(string(filename) + ": invalid opcode " + token);
+			// this is a label for a branch - extract it and save it in the labels map
+			string label = string(token).substr(0, string(token).length() - 1);
+			labels[label] = instruction_nr;
+			// move to next token, which must be the instruction opcode
+			token = strtok_r(NULL, " \t\r", &save);
+			if (token == NULL)
+				return load_failed(string(filename) + ": missing opcode after label " + label);
+			search = opcodes.find(token);
+			if (search == opcodes.end())
+				return load_failed(string(filename) + ": invalid opcode " + token);
+		}
+		if (count_operands(save) < num_operands(search->second))
+			return load_failed(string(filename) + ": missing operands in \"" + source + "\"");
+
+		instr_memory[instruction_nr].opcode = search->second;
+		ctx->source_lines[instruction_nr] = source;
+
+		//reading remaining parameters
+		char *par1;
+		char *par2;
+		char *par3;
+		char *par4;
+		switch (instr_memory[instruction_nr].opcode)
+		{
+		case ADD:
+		case SUB:
+		case XOR:
+		case AND:
+		case MULT:
+		case DIV:
+		case ADDS:
+		case SUBS:
+		case MULTS:
+		case DIVS:
+			par1 = strtok_r(NULL, " \t", &save);
+			par2 = strtok_r(NULL, " \t", &save);
+			par3 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "RF", &save));
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par2, "RF", &save));
+			instr_memory[instruction_nr].src2 = atoi(strtok_r(par3, "RF", &save));
+			break;
+		case FMAS:
+			par1 = strtok_r(NULL, " \t", &save);
+			par2 = strtok_r(NULL, " \t", &save);
+			par3 = strtok_r(NULL, " \t", &save);
+			par4 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "F", &save));
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par2, "F", &save));
+			instr_memory[instruction_nr].src2 = atoi(strtok_r(par3, "F", &save));
+			instr_memory[instruction_nr].src3 = atoi(strtok_r(par4, "F", &save));
+			break;
+		case ADDV:
+		case SUBV:
+		case MULV:
+			par1 = strtok_r(NULL, " \t", &save);
+			par2 = strtok_r(NULL, " \t", &save);
+			par3 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "V", &save));
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par2, "V", &save));
+			instr_memory[instruction_nr].src2 = atoi(strtok_r(par3, "V", &save));
+			break;
+		case ADDI:
+		case SUBI:
+			par1 = strtok_r(NULL, " \t", &save);
+			par2 = strtok_r(NULL, " \t", &save);
+			par3 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "R", &save));
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par2, "R", &save));
+			instr_memory[instruction_nr].immediate = strtoul(par3, NULL, 0);
+			break;
+		case LW:
+		case LWS:
+		case LWV:
+			par1 = strtok_r(NULL, " \t", &save);
+			par2 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].dest = atoi(strtok_r(par1, "RFV", &save));
+			instr_memory[instruction_nr].immediate = strtoul(strtok_r(par2, "()", &save), NULL, 0);
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(NULL, "R", &save));
+			break;
+		case SW:
+		case SWS:
+		case SWV:
+			par1 = strtok_r(NULL, " \t", &save);
+			par2 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par1, "RFV", &save));
+			instr_memory[instruction_nr].immediate = strtoul(strtok_r(par2, "()", &save), NULL, 0);
+			instr_memory[instruction_nr].src2 = atoi(strtok_r(NULL, "R", &save));
+			break;
+		case BEQZ:
+		case BNEZ:
+		case BLTZ:
+		case BGTZ:
+		case BLEZ:
+		case BGEZ:
+			par1 = strtok_r(NULL, " \t", &save);
+			par2 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].src1 = atoi(strtok_r(par1, "R", &save));
+			instr_memory[instruction_nr].label = par2;
+			break;
+		case JUMP:
+			par2 = strtok_r(NULL, " \t", &save);
+			instr_memory[instruction_nr].label = par2;
+		default:
+			break;
+		}
+
+		if (is_vector_alu(instr_memory[instruction_nr].opcode) && !has_vector_res_stations)
+			return load_failed(string(filename) + ": " + instr_names[instr_memory[instruction_nr].opcode] + " needs VECTOR reservation stations");
+
+		/* increment instruction number before moving to next line */
+		instruction_nr++;
+	}
+	ctx->num_instructions = instruction_nr;
+
+	//reconstructing the labels of the branch operations
+	unsigned i = 0;
+	while (true)
+	{
+		if (i == instruction_nr)
+			return load_failed(string(filename) + ": missing EOP");
+		instruction_t instr = instr_memory[i];
+		if (instr.opcode == EOP)
+			break;
+		if (instr.opcode == BLTZ || instr.opcode == BNEZ ||
+			instr.opcode == BGTZ || instr.opcode == BEQZ ||
+			instr.opcode == BGEZ || instr.opcode == BLEZ ||
+			instr.opcode == JUMP)
+		{
+			if (labels.find(instr.label) == labels.end())
+				return load_failed(string(filename) + ": undefined label " + instr.label);
+			instr_memory[i].immediate = (labels[instr.label] - i - 1) << 2;
+		}
+		i++;
+	}
+
+	//marking the macro-op fusion pairs
+	for (unsigned n = 0; n < instruction_nr; n++)
+		instr_memory[n].fuse_next = n + 1 < instruction_nr && fusable(instr_memory[n], instr_memory[n + 1]);
+	return true;
+}
+
+/* reports an error at line "line_nr" of a state file */
+bool sim_ooo::state_error(const char *filename, unsigned line_nr, const string &message)
+{
+	return load_failed(string(filename) + ":" + to_string(line_nr) + ": " + message);
+}
+
+bool sim_ooo::load_state(const char *filename, unsigned thread)
+{
+	ifstream fin(filename, ios::in);
+	if (!fin.is_open())
+		return load_failed("open file " + string(filename) + " failed");
+	return load_state(fin, filename, thread);
+}
+
+bool sim_ooo::load_state(istream &in, const char *filename, unsigned thread)
+{
+	string line;
+	unsigned line_nr = 0;
+	while (getline(in, line))
+	{
+		line_nr++;
+		stringstream ss(line);
+		string target, value;
+		if (!(ss >> target) || target[0] == '#')
+			continue;
+		unsigned address = 0;
+		if (target == "image")
+		{
+			string addr, image;
+			ss >> addr >> image;
+			if (image.empty())
+				return state_error(filename, line_nr, "missing image file");
+			if (!load_memory_image(image.c_str(), strtoul(addr.c_str(), NULL, 0)))
+				return false;
+			continue;
+		}
+		if (target == "M")
+		{
+			string addr;
+			ss >> addr;
+			address = strtoul(addr.c_str(), NULL, 0);
+		}
+		if (!(ss >> value))
+			return state_error(filename, line_nr, "missing value");
+		bool is_float = value.find('.') != string::npos;
+		if (target == "M")
+		{
+			if (address > data_memory_size - 4)
+				return state_error(filename, line_nr, "address out of range");
+			write_memory(address, is_float ? float2unsigned(atof(value.c_str())) : strtoul(value.c_str(), NULL, 0));
+		}
+		else if (target[0] == 'V' && atoi(target.c_str() + 1) < NUM_GP_REGISTERS)
+		{
+			for (unsigned l = 0; l < VECTOR_LANES; l++)
+			{
+				if (l > 0 && !(ss >> value))
+					return state_error(filename, line_nr, "missing lane " + to_string(l));
+				set_vector_register(atoi(target.c_str() + 1), l, atof(value.c_str()), thread);
+			}
+		}
+		else if ((target[0] == 'R' || target[0] == 'F') && atoi(target.c_str() + 1) < NUM_GP_REGISTERS)
+		{
+			if (target[0] == 'R')
+				set_int_register(atoi(target.c_str() + 1), strtoul(value.c_str(), NULL, 0), thread);
+			else
+				set_fp_register(atoi(target.c_str() + 1), atof(value.c_str()), thread);
+		}
+		else
+			return state_error(filename, line_nr, "invalid target " + target);
+	}
+	return true;
+}
+
+/* ============================================================================
+
+   Simulator creation, initialization and deallocation 
+
+   =========================================================================== */
+
+sim_ooo::sim_ooo(unsigned mem_size,
+				 unsigned rob_size,
+				 unsigned num_int_res_stations,
+				 unsigned num_add_res_stations,
+				 unsigned num_mul_res_stations,
+				 unsigned num_load_res_stations,
+				 unsigned max_issue,
+				 unsigned num_vector_res_stations)
+{
+	//memory
+	data_memory_size = mem_size;
+	data_memory = allocate_memory(data_memory_size);
+	owns_memory = true;
+	exit_on_error = true;
+	hierarchy = NULL;
+	core_id = 0;
+
+	//issue width
+	issue_width = max_issue;
+
+	//rob, instruction window, reservation stations
+	rob.entries = NULL;
+	pending_instructions.entries = NULL;
+	reservation_stations.entries = NULL;
+	for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
+		rs_tags[k] = NULL;
+	rs_valid = rs_ready = rs_match = NULL;
+	select_order = NULL;
+	select_keys = NULL;
+	init_window(rob_size, num_int_res_stations, num_add_res_stations, num_mul_res_stations, num_load_res_stations, num_vector_res_stations);
+
+	//execution units
+	num_units = 0;
+	histograms_enabled = false;
+	profiler_enabled = false;
+
+	//a single hardware thread
+	num_threads = 1;
+	contexts = new hw_context_t[num_threads];
+	fetch_policy = FETCH_ROUND_ROBIN;
+	partitioned_rob = false;
+
+	//ideal front-end
+	frontend_enabled = false;
+	icache_sets = 0;
+	loop_buffer_size = 0;
+	icache_tags = NULL;
+	icache_last_use = NULL;
+
+	//stores take the memory unit at commit
+	store_buffer_size = 0;
+	store_drain_cycles = 1;
+	store_line_size = 32;
+	store_buffer = NULL;
+
+	//SIMD tag matching, reservation stations examined in order, idle cycles skipped, no move elimination
+	simd_enabled = true;
+	skipping_enabled = true;
+	select_policy = SELECT_POSITION;
+	elimination_enabled = false;
+	fusion_enabled = false;
+	init_energy_table();
+
+	//results kept in the ROB
+	prf_enabled = false;
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+	{
+		prf_size[k] = 0;
+		prf_values[k] = NULL;
+		free_list[k] = NULL;
+	}
+	reset();
+}
+
+sim_ooo::~sim_ooo()
+{
+	if (owns_memory)
+		free_memory(data_memory, data_memory_size);
+	delete[] rob.entries;
+	delete[] pending_instructions.entries;
+	delete[] reservation_stations.entries;
+	delete[] contexts;
+	delete[] select_order;
+	delete[] select_keys;
+	for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
+		delete[] rs_tags[k];
+	delete[] rs_valid;
+	delete[] rs_ready;
+	delete[] rs_match;
+	delete[] icache_tags;
+	delete[] icache_last_use;
+	delete[] store_buffer;
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+	{
+		delete[] prf_values[k];
+		delete[] free_list[k];
+	}
+}
+
+/* (re)allocates the ROB, the instruction window and the reservation stations; the arrays are kept if their size does not change */
+void sim_ooo::init_window(unsigned rob_size, unsigned num_int_res_stations, unsigned num_add_res_stations, unsigned num_mul_res_stations, unsigned num_load_res_stations, unsigned num_vector_res_stations)
+{
+	//ROB indices are stored in the 16-bit operand tags
+	if (rob_size >= NO_TAG)
+	{
+		cerr << "error: the ROB cannot have more than " << NO_TAG - 1 << " entries!" << endl;
+		exit(-1);
+	}
+	if (rob.entries == NULL || rob.num_entries != rob_size)
+	{
+		delete[] rob.entries;
+		delete[] pending_instructions.entries;
+		rob.num_entries = rob_size;
+		pending_instructions.num_entries = rob_size;
+		rob.entries = new rob_entry_t[rob_size];
+		pending_instructions.entries = new instr_window_entry_t[rob_size];
+	}
+	unsigned num_entries = num_int_res_stations + num_load_res_stations + num_add_res_stations + num_mul_res_stations + num_vector_res_stations;
+	if (reservation_stations.entries == NULL || reservation_stations.num_entries != num_entries)
+	{
+		delete[] reservation_stations.entries;
+		delete[] select_order;
+		delete[] select_keys;
+		reservation_stations.num_entries = num_entries;
+		reservation_stations.entries = new res_station_entry_t[num_entries];
+		select_order = new unsigned[num_entries];
+		select_keys = new unsigned long long[num_entries];
+
+		//operand tags (structure of arrays) and bitmaps of the reservation stations
+		rs_slots = (num_entries + 63) / 64 * 64;
+		for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
+		{
+			delete[] rs_tags[k];
+			rs_tags[k] = new rs_tag_t[rs_slots];
+		}
+		delete[] rs_valid;
+		delete[] rs_ready;
+		delete[] rs_match;
+		rs_valid = new unsigned long long[rs_slots / 64];
+		rs_ready = new unsigned long long[rs_slots / 64];
+		rs_match = new unsigned long long[rs_slots / 64];
+	}
+	//types of the reservation stations
+	unsigned n = 0;
+	for (unsigned i = 0; i < num_int_res_stations; i++, n++)
+	{
+		reservation_stations.entries[n].type = INTEGER_RS;
+		reservation_stations.entries[n].name = i;
+	}
+	for (unsigned i = 0; i < num_load_res_stations; i++, n++)
+	{
+		reservation_stations.entries[n].type = LOAD_B;
+		reservation_stations.entries[n].name = i;
+	}
+	for (unsigned i = 0; i < num_add_res_stations; i++, n++)
+	{
+		reservation_stations.entries[n].type = ADD_RS;
+		reservation_stations.entries[n].name = i;
+	}
+	for (unsigned i = 0; i < num_mul_res_stations; i++, n++)
+	{
+		reservation_stations.entries[n].type = MULT_RS;
+		reservation_stations.entries[n].name = i;
+	}
+	for (unsigned i = 0; i < num_vector_res_stations; i++, n++)
+	{
+		reservation_stations.entries[n].type = VECTOR_RS;
+		reservation_stations.entries[n].name = i;
+	}
+}
+
+void sim_ooo::reconfigure(unsigned rob_size,
+						  unsigned num_int_res_stations,
+						  unsigned num_add_res_stations,
+						  unsigned num_mul_res_stations,
+						  unsigned num_load_res_stations,
+						  unsigned max_issue,
+						  unsigned num_vector_res_stations)
+{
+	issue_width = max_issue;
+	init_window(rob_size, num_int_res_stations, num_add_res_stations, num_mul_res_stations, num_load_res_stations, num_vector_res_stations);
+
+	//no execution units
+	num_units = 0;
+
+	//default modes: single thread, ideal front-end, results in the ROB, no histograms or profiler
+	if (num_threads != 1)
+	{
+		delete[] contexts;
+		num_threads = 1;
+		contexts = new hw_context_t[num_threads];
+	}
+	fetch_policy = FETCH_ROUND_ROBIN;
+	partitioned_rob = false;
+	frontend_enabled = false;
+	icache_sets = 0;
+	loop_buffer_size = 0;
+	delete[] icache_tags;
+	delete[] icache_last_use;
+	icache_tags = NULL;
+	icache_last_use = NULL;
+	store_buffer_size = 0;
+	delete[] store_buffer;
+	store_buffer = NULL;
+	prf_enabled = false;
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+	{
+		delete[] prf_values[k];
+		delete[] free_list[k];
+		prf_size[k] = 0;
+		prf_values[k] = NULL;
+		free_list[k] = NULL;
+	}
+	select_policy = SELECT_POSITION;
+	simd_enabled = true;
+	skipping_enabled = true;
+	elimination_enabled = false;
+	fusion_enabled = false;
+	histograms_enabled = false;
+	profiler_enabled = false;
+	init_energy_table();
+
+	log.str("");
+	reset();
+}
+
+void sim_ooo::attach_memory(unsigned char *memory, unsigned mem_size)
+{
+	if (owns_memory)
+		free_memory(data_memory, data_memory_size);
+	data_memory = memory;
+	data_memory_size = mem_size;
+	owns_memory = false;
+}
+
+void sim_ooo::set_memory_hierarchy(memory_hierarchy *memory, unsigned core)
+{
+	hierarchy = memory;
+	core_id = core;
+}
+
+void sim_ooo::init_threads(unsigned threads, fetch_policy_t fetch, bool partition_rob)
+{
+	if (threads == 0 || threads > MAX_THREADS || (partition_rob && threads > rob.num_entries) || (prf_enabled && (prf_size[INT_PRF] <= threads * NUM_GP_REGISTERS || prf_size[FP_PRF] <= threads * NUM_GP_REGISTERS)))
+	{
+		cerr << "error: invalid number of hardware threads " << threads << "!" << endl;
+		exit(-1);
+	}
+	delete[] contexts;
+	num_threads = threads;
+	contexts = new hw_context_t[num_threads];
+	fetch_policy = fetch;
+	partitioned_rob = partition_rob;
+	log.str("");
+	reset();
+}
+
+/* selects the thread that issues in the current clock cycle (threads whose program is over are skipped) */
+unsigned sim_ooo::select_thread()
+{
+	unsigned selected = issue_thread;
+	unsigned fewest = UNDEFINED;
+	for (unsigned k = 1; k <= num_threads; k++)
+	{
+		unsigned t = (issue_thread + k) % num_threads;
+		if (instruction_of(t, contexts[t].PC).opcode == EOP)
+			continue;
+		if (fetch_policy == FETCH_ROUND_ROBIN)
+			return t;
+		// ICOUNT: instructions of the thread waiting in the reservation stations
+		unsigned count = 0;
+		for (unsigned i = 0; i < rob.num_entries; i++)
+			if (rob.entries[i].pc != UNDEFINED && rob.entries[i].thread == t && rob.entries[i].state == ISSUE)
+				count++;
+		if (count < fewest)
+		{
+			fewest = count;
+			selected = t;
+		}
+	}
+	return selected;
+}
+
+bool sim_ooo::thread_completed(unsigned thread)
+{
+	for (unsigned i = 0; i < rob.num_entries; i++)
+	{
+		if (rob.entries[i].pc != UNDEFINED && rob.entries[i].thread == thread)
+			return false;
+	}
+	return instruction_of(thread, contexts[thread].PC).opcode == EOP;
+}
+
+instruction_t &sim_ooo::instruction_of(unsigned thread, unsigned pc)
+{
+	return contexts[thread].instr_memory[(pc - contexts[thread].instr_base_address) >> 2];
+}
+
+pc_profile_t &sim_ooo::profile_of(unsigned thread, unsigned pc)
+{
+	return contexts[thread].profile[(pc - contexts[thread].instr_base_address) >> 2];
+}
+
+/* ============================================================================
+
+   Decoupled front-end
+
+   =========================================================================== */
+
+void sim_ooo::init_frontend(unsigned width, unsigned decode, unsigned queue_size, unsigned icache_size, unsigned assoc, unsigned line, unsigned miss_latency)
+{
+	if (queue_size > MAX_FETCH_QUEUE || (width != 0 && queue_size == 0) || (icache_size != 0 && (assoc == 0 || line < 4 || icache_size < assoc * line)))
+	{
+		cerr << "error: invalid front-end configuration!" << endl;
+		exit(-1);
+	}
+	frontend_enabled = width != 0;
+	fetch_width = width;
+	decode_latency = decode;
+	fetch_queue_size = queue_size;
+	icache_sets = icache_size / (assoc * line);
+	icache_assoc = assoc;
+	icache_line = line;
+	icache_miss_latency = miss_latency;
+	delete[] icache_tags;
+	delete[] icache_last_use;
+	icache_tags = icache_sets ? new unsigned[icache_sets * icache_assoc] : NULL;
+	icache_last_use = icache_sets ? new unsigned[icache_sets * icache_assoc] : NULL;
+	log.str("");
+	reset();
+}
+
+bool sim_ooo::icache_access(unsigned address)
+{
+	unsigned tag = address / icache_line;
+	unsigned *tags = &icache_tags[(tag % icache_sets) * icache_assoc];
+	unsigned *last_use = &icache_last_use[(tag % icache_sets) * icache_assoc];
+	unsigned victim = 0;
+	frontend_stats.icache_accesses++;
+	for (unsigned w = 0; w < icache_assoc; w++)
+	{
+		if (tags[w] == tag)
+		{
+			last_use[w] = ++icache_use_counter;
+			return true;
+		}
+		if (tags[w] == UNDEFINED || (tags[victim] != UNDEFINED && last_use[w] < last_use[victim]))
+			victim = w;
+	}
+	frontend_stats.icache_misses++;
+	tags[victim] = tag;
+	last_use[victim] = ++icache_use_counter;
+	return false;
+}
+
+/* the threads fetch in turns, until the end of their program (EOP is not fetched); a miss blocks the fetch of its
+   thread until the line arrives */
+void sim_ooo::fetch()
+{
+	unsigned thread = clock_cycles % num_threads;
+	hw_context_t *ctx = &contexts[thread];
+	if (ctx->fetch_pc == UNDEFINED)
+		ctx->fetch_pc = ctx->PC;
+	if (clock_cycles < ctx->fetch_stall_until)
+	{
+		frontend_stats.icache_stall_cycles++;
+		return;
+	}
+	if (ctx->fetch_count == fetch_queue_size)
+	{
+		frontend_stats.queue_full_cycles++;
+		return;
+	}
+	if (ctx->instr_memory[(ctx->fetch_pc - ctx->instr_base_address) / 4].opcode == EOP)
+		return;
+	if (ctx->loop_start != UNDEFINED && ctx->fetch_pc >= ctx->loop_start && ctx->fetch_pc <= ctx->loop_end)
+	{
+		//the loop buffer holds decoded instructions: no instruction cache access, no decode latency, and the loop
+		//branch predicted taken
+		for (unsigned n = 0; n < fetch_width && ctx->fetch_count < fetch_queue_size; n++)
+		{
+			fetch_entry_t *entry = &ctx->fetch_queue[(ctx->fetch_head + ctx->fetch_count) % MAX_FETCH_QUEUE];
+			entry->pc = ctx->fetch_pc;
+			entry->ready_cycle = clock_cycles + 1;
+			entry->next_pc = ctx->fetch_pc == ctx->loop_end ? ctx->loop_start : ctx->fetch_pc + 4;
+			ctx->fetch_count++;
+			frontend_stats.fetched++;
+			frontend_stats.loop_delivered++;
+			ctx->fetch_pc = entry->next_pc;
+		}
+		return;
+	}
+	if (icache_sets != 0 && !icache_access(ctx->fetch_pc))
+	{
+		ctx->fetch_stall_until = clock_cycles + icache_miss_latency;
+		frontend_stats.icache_stall_cycles++;
+		return;
+	}
+	for (unsigned n = 0; n < fetch_width && ctx->fetch_count < fetch_queue_size && ctx->instr_memory[(ctx->fetch_pc - ctx->instr_base_address) / 4].opcode != EOP; n++)
+	{
+		fetch_entry_t *entry = &ctx->fetch_queue[(ctx->fetch_head + ctx->fetch_count) % MAX_FETCH_QUEUE];
+		entry->pc = ctx->fetch_pc;
+		entry->ready_cycle = clock_cycles + 1 + decode_latency;
+		entry->next_pc = ctx->fetch_pc + 4;
+		ctx->fetch_count++;
+		frontend_stats.fetched++;
+		ctx->fetch_pc += 4;
+		if (icache_sets != 0 && ctx->fetch_pc % icache_line == 0)
+			break;
+	}
+}
+
+bool sim_ooo::fetched(unsigned thread, unsigned pc)
+{
+	hw_context_t *ctx = &contexts[thread];
+	return ctx->fetch_count > 0 && ctx->fetch_queue[ctx->fetch_head].pc == pc && ctx->fetch_queue[ctx->fetch_head].ready_cycle <= clock_cycles;
+}
+
+void sim_ooo::pop_fetch_queue(unsigned thread)
+{
+	hw_context_t *ctx = &contexts[thread];
+	ctx->issue_next_pc = ctx->fetch_queue[ctx->fetch_head].next_pc;
+	ctx->fetch_head = (ctx->fetch_head + 1) % MAX_FETCH_QUEUE;
+	ctx->fetch_count--;
+}
+
+unsigned sim_ooo::next_issue_pc(unsigned pc)
+{
+	return frontend_enabled ? contexts[issue_thread].issue_next_pc : pc + 4;
+}
+
+void sim_ooo::redirect_fetch(unsigned thread, unsigned pc, unsigned branch_pc)
+{
+	hw_context_t *ctx = &contexts[thread];
+	frontend_stats.squashed += ctx->fetch_count;
+	ctx->fetch_count = 0;
+	ctx->fetch_pc = pc;
+	ctx->fetch_stall_until = 0;
+
+	//loop detection: the other branches do not break the sequence, so that an inner loop survives its outer loop
+	if (loop_buffer_size == 0 || pc > branch_pc || (branch_pc - pc) / 4 + 1 > loop_buffer_size)
+		return;
+	if (ctx->loop_candidate == branch_pc)
+		ctx->loop_iterations++;
+	else
+	{
+		ctx->loop_candidate = branch_pc;
+		ctx->loop_iterations = 1;
+	}
+	if (ctx->loop_iterations >= LOOP_DETECT_ITERATIONS && (ctx->loop_start != pc || ctx->loop_end != branch_pc))
+	{
+		ctx->loop_start = pc;
+		ctx->loop_end = branch_pc;
+		frontend_stats.loop_captures++;
+	}
+}
+
+void sim_ooo::init_loop_buffer(unsigned size)
+{
+	loop_buffer_size = size;
+	log.str("");
+	reset();
+}
+
+frontend_stats_t sim_ooo::get_frontend_stats() { return frontend_stats; }
+
+void sim_ooo::print_frontend_stats()
+{
+	if (!frontend_enabled)
+		return;
+	frontend_stats_t *stats = &frontend_stats;
+	cout << "FRONT-END (fetch width " << dec << fetch_width << ", decode latency " << decode_latency << ", fetch queue " << fetch_queue_size << ", ";
+	if (icache_sets)
+		cout << icache_sets * icache_assoc * icache_line << "B " << icache_assoc << "-way I-cache with " << icache_line << "B lines, miss latency " << icache_miss_latency << ")" << endl;
+	else
+		cout << "perfect I-cache)" << endl;
+	cout << "Fetched instructions = " << stats->fetched << " (" << stats->squashed << " squashed by mispredictions)" << endl;
+	if (icache_sets)
+		cout << "I-cache accesses = " << stats->icache_accesses << ", misses = " << stats->icache_misses << ", fetch stall cycles = " << stats->icache_stall_cycles << endl;
+	cout << "Fetch queue full cycles = " << stats->queue_full_cycles << ", issue starved cycles = " << stats->starved_cycles << endl;
+	if (loop_buffer_size)
+	{
+		streamsize precision = cout.precision();
+		cout << "Loop buffer (" << loop_buffer_size << " instructions): captures = " << stats->loop_captures << ", delivered = " << stats->loop_delivered;
+		cout << " (" << fixed << setprecision(1) << (stats->fetched ? 100.0 * stats->loop_delivered / stats->fetched : 0.0) << "% of the fetched instructions)" << endl;
+		cout.unsetf(ios::floatfield);
+		cout.precision(precision);
+	}
+	cout << endl;
+}
+
+/* ============================================================================
+
+   Scheduler
+
+   =========================================================================== */
+
+void sim_ooo::set_select_policy(select_policy_t policy)
+{
+	select_policy = policy;
+}
+
+/* the reservation stations are sorted by insertion on their key (there are few of them); free stations go last */
+void sim_ooo::schedule()
+{
+	unsigned n = reservation_stations.num_entries;
+	for (unsigned i = 0; i < n; i++)
+	{
+		res_station_entry_t *entry = &reservation_stations.entries[i];
+		select_order[i] = i;
+		if (entry->pc == UNDEFINED || entry->destination == UNDEFINED)
+			select_keys[i] = ~0ULL;
+		else if (select_policy == SELECT_OLDEST_FIRST)
+			select_keys[i] = rob.entries[entry->destination].seq;
+		else if (select_policy == SELECT_CRITICAL_FIRST)
+		{
+			hw_context_t *owner = &contexts[entry->thread];
+			unsigned criticality = owner->criticality[(entry->pc - owner->instr_base_address) / 4];
+			select_keys[i] = ((unsigned long long)(MAX_CRITICALITY - criticality) << 56) | rob.entries[entry->destination].seq;
+		}
+		else
+		{
+			select_seed = select_seed * 1103515245 + 12345;
+			select_keys[i] = select_seed >> 8;
+		}
+	}
+	for (unsigned i = 1; i < n; i++)
+	{
+		unsigned index = select_order[i];
+		unsigned j = i;
+		for (; j > 0 && select_keys[select_order[j - 1]] > select_keys[index]; j--)
+			select_order[j] = select_order[j - 1];
+		select_order[j] = index;
+	}
+}
+
+void sim_ooo::mark_critical()
+{
+	for (unsigned t = 0; t < num_threads; t++)
+	{
+		unsigned oldest = UNDEFINED;
+		for (unsigned i = 0; i < rob.num_entries; i++)
+		{
+			if (rob.entries[i].pc != UNDEFINED && rob.entries[i].thread == t && (oldest == UNDEFINED || rob.entries[i].seq < rob.entries[oldest].seq))
+				oldest = i;
+		}
+		if (oldest != UNDEFINED && pending_instructions.entries[oldest].wr == UNDEFINED)
+			rob.entries[oldest].blocked_commit = true;
+	}
+}
+
+void sim_ooo::train_criticality(unsigned rob_index)
+{
+	rob_entry_t *entry = &rob.entries[rob_index];
+	if (select_policy != SELECT_CRITICAL_FIRST)
+		return;
+	hw_context_t *owner = &contexts[entry->thread];
+	unsigned char *counter = &owner->criticality[(entry->pc - owner->instr_base_address) / 4];
+	if (entry->blocked_commit && *counter < MAX_CRITICALITY)
+		(*counter)++;
+	else if (!entry->blocked_commit && *counter > 0)
+		(*counter)--;
+}
+
+/* ============================================================================
+
+   Merged physical register files
+
+   =========================================================================== */
+
+void sim_ooo::init_prf(unsigned int_regs, unsigned fp_regs)
+{
+	unsigned sizes[NUM_PRF_TYPES] = {int_regs, fp_regs};
+	prf_enabled = int_regs != 0 || fp_regs != 0;
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+	{
+		if (prf_enabled && sizes[k] <= num_threads * NUM_GP_REGISTERS)
+		{
+			cerr << "error: the " << prf_names[k] << " register file needs more than " << num_threads * NUM_GP_REGISTERS << " registers!" << endl;
+			exit(-1);
+		}
+		delete[] prf_values[k];
+		delete[] free_list[k];
+		prf_size[k] = prf_enabled ? sizes[k] : 0;
+		prf_values[k] = prf_enabled ? new unsigned[prf_size[k]] : NULL;
+		free_list[k] = prf_enabled ? new unsigned[prf_size[k]] : NULL;
+	}
+	log.str("");
+	reset();
+}
+
+unsigned sim_ooo::result_of(unsigned rob_index)
+{
+	rob_entry_t *entry = &rob.entries[rob_index];
+	if (prf_enabled && entry->phys_dest != UNDEFINED)
+		return prf_values[entry->destination < NUM_GP_REGISTERS ? INT_PRF : FP_PRF][entry->phys_dest];
+	return entry->value;
+}
+
+void sim_ooo::write_result(unsigned rob_index, unsigned value)
+{
+	rob_entry_t *entry = &rob.entries[rob_index];
+	if (prf_enabled && entry->phys_dest != UNDEFINED)
+	{
+		prf_values[entry->destination < NUM_GP_REGISTERS ? INT_PRF : FP_PRF][entry->phys_dest] = value;
+		energy_events[EVENT_RF_WRITE]++;
+	}
+	else
+	{
+		entry->value = value;
+		energy_events[EVENT_ROB_WRITE]++;
+	}
+}
+
+/* the destination field of the ROB entry tells the register file (registers of the FP file are offset by NUM_GP_REGISTERS) */
+void sim_ooo::allocate_register(unsigned rob_index)
+{
+	rob_entry_t *entry = &rob.entries[rob_index];
+	if (!writes_register(instruction_of(entry->thread, entry->pc).opcode))
+		return;
+	unsigned k = entry->destination < NUM_GP_REGISTERS ? INT_PRF : FP_PRF;
+	entry->phys_dest = free_list[k][free_head[k]];
+	prf_values[k][entry->phys_dest] = UNDEFINED;
+	free_head[k] = (free_head[k] + 1) % prf_size[k];
+	free_count[k]--;
+	min_free_count[k] = min(min_free_count[k], free_count[k]);
+	prf_allocations[k]++;
+}
+
+void sim_ooo::release_register(unsigned rob_index)
+{
+	rob_entry_t *entry = &rob.entries[rob_index];
+	if (!prf_enabled || entry->pc == UNDEFINED || entry->phys_dest == UNDEFINED)
+		return;
+	unsigned k = entry->destination < NUM_GP_REGISTERS ? INT_PRF : FP_PRF;
+	free_list[k][(free_head[k] + free_count[k]) % prf_size[k]] = entry->phys_dest;
+	free_count[k]++;
+	entry->phys_dest = UNDEFINED;
+}
+
+void sim_ooo::retire_register(unsigned rob_index)
+{
+	rob_entry_t *entry = &rob.entries[rob_index];
+	if (!prf_enabled || entry->phys_dest == UNDEFINED)
+		return;
+	hw_context_t *owner = &contexts[entry->thread];
+	unsigned k = entry->destination < NUM_GP_REGISTERS ? INT_PRF : FP_PRF;
+	unsigned *map = k == INT_PRF ? &owner->INT_retire_map[entry->destination] : &owner->FP_retire_map[entry->destination - NUM_GP_REGISTERS];
+	free_list[k][(free_head[k] + free_count[k]) % prf_size[k]] = *map;
+	free_count[k]++;
+	*map = entry->phys_dest;
+}
+
+unsigned long long sim_ooo::get_prf_stall_cycles(prf_type_t type) { return prf_stall_cycles[type]; }
+
+void sim_ooo::print_prf_stats()
+{
+	if (!prf_enabled)
+		return;
+	cout << "PHYSICAL REGISTER FILES" << endl;
+	cout << setfill(' ') << setw(5) << "File" << setw(7) << "Size" << setw(13) << "Allocations" << setw(9) << "MinFree" << setw(13) << "StallCycles" << endl;
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+		cout << setw(5) << prf_names[k] << setw(7) << dec << prf_size[k] << setw(13) << prf_allocations[k] << setw(9) << min_free_count[k] << setw(13) << prf_stall_cycles[k] << endl;
+	cout << endl;
+}
+
+/* ============================================================================
+
+   Move elimination
+
+   =========================================================================== */
+
+void sim_ooo::enable_move_elimination(bool enable)
+{
+	elimination_enabled = enable;
+}
+
+/* a zero idiom does not depend on its source; a move or an immediate load needs the value of its source, either
+   committed or already written in the ROB, and a result other than UNDEFINED (the ROB marker of a pending result) */
+bool sim_ooo::eliminate(unsigned pc, unsigned *value, bool *zero)
+{
+	instruction_t &instruction = instruction_of(issue_thread, pc);
+	hw_context_t *ctx = &contexts[issue_thread];
+	*zero = (instruction.opcode == XOR || instruction.opcode == SUB) && instruction.src1 == instruction.src2;
+	if (*zero)
+	{
+		*value = 0;
+		return true;
+	}
+	if (instruction.opcode != ADDI)
+		return false;
+	unsigned tag = ctx->INT_tags[instruction.src1];
+	if (tag != UNDEFINED && result_of(tag) == UNDEFINED)
+		return false;
+	unsigned source = tag == UNDEFINED ? (unsigned)ctx->INT_regs[instruction.src1] : result_of(tag);
+	if (instruction.immediate != 0 && source != 0)
+		return false;
+	*value = source + instruction.immediate;
+	// an eliminated instruction never broadcasts: a result equal to the sentinel would leave its consumers waiting forever
+	return *value != UNDEFINED;
+}
+
+unsigned long long sim_ooo::get_eliminated_instructions() { return eliminated_zero_idioms + eliminated_moves; }
+
+void sim_ooo::print_elimination_stats()
+{
+	if (!elimination_enabled)
+		return;
+	cout << "MOVE ELIMINATION" << endl;
+	cout << "Zero idioms eliminated = " << dec << eliminated_zero_idioms << endl;
+	cout << "Moves and immediate loads eliminated = " << eliminated_moves << endl;
+	cout << endl;
+}
+
+/* ============================================================================
+
+   Macro-op fusion
+
+   =========================================================================== */
+
+void sim_ooo::enable_fusion(bool enable)
+{
+	fusion_enabled = enable;
+}
+
+bool sim_ooo::can_fuse(unsigned pc)
+{
+	hw_context_t *ctx = &contexts[issue_thread];
+	instruction_t &second = instruction_of(issue_thread, pc + 4);
+	unsigned next = partitioned_rob ? ctx->rob_next : rob_next;
+	for (unsigned k = 0; k < 2; k++)
+	{
+		if (next == ctx->rob_end)
+			next = ctx->rob_start;
+		if (rob.entries[next++].pc != UNDEFINED)
+			return false;
+	}
+	if (prf_enabled)
+	{
+		unsigned needed[NUM_PRF_TYPES] = {1, 0};
+		if (second.opcode == LW)
+			needed[INT_PRF]++;
+		else if (second.opcode == LWS)
+			needed[FP_PRF]++;
+		for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+			if (free_count[k] < needed[k])
+				return false;
+	}
+	if (frontend_enabled)
+	{
+		fetch_entry_t *entry = &ctx->fetch_queue[(ctx->fetch_head + 1) % MAX_FETCH_QUEUE];
+		if (!fetched(issue_thread, pc) || ctx->fetch_count < 2 || entry->pc != pc + 4 || entry->ready_cycle > clock_cycles)
+			return false;
+	}
+	return true;
+}
+
+/* the micro-op is the load of a load pair, with the immediate of the first instruction folded in its address, and
+   the first instruction of a branch pair */
+bool sim_ooo::issue_fused_pair(unsigned pc)
+{
+	hw_context_t *ctx = &contexts[issue_thread];
+	instruction_t &first = instruction_of(issue_thread, pc);
+	instruction_t &second = instruction_of(issue_thread, pc + 4);
+	bool load = is_load(second.opcode);
+	int station = -1;
+	for (unsigned i = 0; i < reservation_stations.num_entries && station < 0; i++)
+		if (reservation_stations.entries[i].type == (load ? LOAD_B : INTEGER_RS) && reservation_stations.entries[i].pc == UNDEFINED)
+			station = i;
+	if (station < 0)
+		return false;
+
+	//each instruction takes its ROB entry
+	unsigned &next = partitioned_rob ? ctx->rob_next : rob_next;
+	unsigned entries[2];
+	for (unsigned k = 0; k < 2; k++)
+	{
+		instruction_t &instruction = k ? second : first;
+		if (next == ctx->rob_end)
+			next = ctx->rob_start;
+		entries[k] = next++;
+		rob_entry_t *entry = &rob.entries[entries[k]];
+		entry->pc = pc + 4 * k;
+		entry->thread = issue_thread;
+		entry->destination = instruction.opcode == LWS ? instruction.dest + NUM_GP_REGISTERS : instruction.dest;
+		entry->state = ISSUE;
+		entry->value = UNDEFINED;
+		entry->seq = issue_sequence++;
+		if (k == 0)
+			count_issue_events(pc, true);
+		else
+			energy_events[EVENT_ROB_WRITE]++;
+		if (frontend_enabled)
+			pop_fetch_queue(issue_thread);
+		entry->predicted_pc = next_issue_pc(entry->pc);
+		if (prf_enabled)
+			allocate_register(entries[k]);
+		pending_instructions.entries[entries[k]].pc = entry->pc;
+		pending_instructions.entries[entries[k]].thread = issue_thread;
+		pending_instructions.entries[entries[k]].issue = clock_cycles;
+	}
+
+	res_station_entry_t *entry = &reservation_stations.entries[station];
+	entry->pc = load ? pc + 4 : pc;
+	rs_valid[station / 64] |= 1ULL << (station % 64);
+	entry->thread = issue_thread;
+	entry->destination = entries[load ? 1 : 0];
+	entry->fused_destination = entries[load ? 0 : 1];
+	if (load)
+		entry->address = alu(first.opcode, 0, 0, first.immediate, pc) + second.immediate;
+	unsigned tag = ctx->INT_tags[first.src1];
+	if (tag == UNDEFINED)
+		entry->value1 = ctx->INT_regs[first.src1];
+	else if (result_of(tag) != UNDEFINED)
+		entry->value1 = result_of(tag);
+	else
+		rs_tags[0][station] = tag;
+	ctx->INT_tags[first.dest] = entries[0];
+	if (second.opcode == LWS)
+		ctx->FP_tags[second.dest] = entries[1];
+	else if (second.opcode == LW)
+		ctx->INT_tags[second.dest] = entries[1];
+	if (load)
+		fused_load_pairs++;
+	else
+		fused_branch_pairs++;
+	return true;
+}
+
+void sim_ooo::start_fused(unsigned res_station)
+{
+	unsigned other = reservation_stations.entries[res_station].fused_destination;
+	rob.entries[other].state = EXECUTE;
+	pending_instructions.entries[other].exe = clock_cycles;
+}
+
+/* the branch of a branch pair resolves on the result of the micro-op; the first instruction of a load pair
+   computes its result from the base register */
+void sim_ooo::complete_fused(unsigned res_station, unsigned value)
+{
+	res_station_entry_t *entry = &reservation_stations.entries[res_station];
+	unsigned other = entry->fused_destination;
+	unsigned result;
+	if (is_load(instruction_of(entry->thread, entry->pc).opcode))
+	{
+		instruction_t &first = instruction_of(entry->thread, entry->pc - 4);
+		result = alu(first.opcode, entry->value1, 0, first.immediate, entry->pc - 4);
+	}
+	else
+	{
+		instruction_t &branch = instruction_of(entry->thread, entry->pc + 4);
+		result = alu(branch.opcode, value, 0, branch.immediate, entry->pc + 4);
+	}
+	write_result(other, result);
+	rob.entries[other].state = WRITE_RESULT;
+	pending_instructions.entries[other].wr = clock_cycles;
+	broadcast(other, result, NULL);
+}
+
+unsigned long long sim_ooo::get_fused_pairs() { return fused_branch_pairs + fused_load_pairs; }
+
+void sim_ooo::print_fusion_stats()
+{
+	if (!fusion_enabled)
+		return;
+	cout << "MACRO-OP FUSION" << endl;
+	cout << "Branch pairs fused = " << dec << fused_branch_pairs << endl;
+	cout << "Load pairs fused = " << fused_load_pairs << endl;
+	cout << endl;
+}
+
+/* ============================================================================
+
+   Post-commit store buffer
+
+   =========================================================================== */
+
+void sim_ooo::init_store_buffer(unsigned entries, unsigned drain_cycles, unsigned line)
+{
+	if (entries > 0 && (drain_cycles == 0 || line < 4 || (line & (line - 1)) != 0))
+	{
+		cerr << "error: invalid store buffer drain cycles " << drain_cycles << " or line size " << line << "!" << endl;
+		exit(-1);
+	}
+	delete[] store_buffer;
+	store_buffer_size = entries;
+	store_drain_cycles = drain_cycles;
+	store_line_size = line;
+	store_buffer = entries ? new store_buffer_entry_t[entries] : NULL;
+	reset();
+}
+
+/* the entry being drained has already sent its data to memory, so a store to its line takes a new entry */
+bool sim_ooo::buffer_store(unsigned address, unsigned pc)
+{
+	unsigned line = address / store_line_size;
+	for (unsigned n = 0; n < store_buffer_count; n++)
+	{
+		store_buffer_entry_t *entry = &store_buffer[(store_buffer_head + n) % store_buffer_size];
+		if (entry->line == line && entry->drain_done == UNDEFINED)
+		{
+			store_buffer_stats.stores++;
+			store_buffer_stats.combined++;
+			return true;
+		}
+	}
+	if (store_buffer_count == store_buffer_size)
+		return false;
+	store_buffer_entry_t *entry = &store_buffer[(store_buffer_head + store_buffer_count) % store_buffer_size];
+	entry->line = line;
+	entry->pc = pc;
+	entry->drain_done = UNDEFINED;
+	store_buffer_count++;
+	store_buffer_stats.stores++;
+	store_buffer_stats.max_occupancy = max(store_buffer_stats.max_occupancy, store_buffer_count);
+	return true;
+}
+
+/* the next entry starts draining in the clock cycle in which the previous one is written */
+void sim_ooo::drain_store_buffer()
+{
+	if (store_buffer_count > 0 && store_buffer[store_buffer_head].drain_done <= clock_cycles)
+	{
+		store_buffer_head = (store_buffer_head + 1) % store_buffer_size;
+		store_buffer_count--;
+	}
+	if (store_buffer_count == 0 || store_buffer[store_buffer_head].drain_done != UNDEFINED)
+		return;
+	store_buffer_entry_t *entry = &store_buffer[store_buffer_head];
+	entry->drain_done = clock_cycles + store_drain_cycles;
+	if (hierarchy != NULL)
+		entry->drain_done += hierarchy->access(core_id, entry->line * store_line_size, true, clock_cycles, entry->pc);
+	store_buffer_stats.drains++;
+	energy_events[EVENT_MEM_WRITE]++;
+}
+
+store_buffer_stats_t sim_ooo::get_store_buffer_stats() { return store_buffer_stats; }
+
+void sim_ooo::print_store_buffer_stats()
+{
+	if (!store_buffer_size)
+		return;
+	store_buffer_stats_t *stats = &store_buffer_stats;
+	cout << "STORE BUFFER (" << dec << store_buffer_size << " entries, " << store_line_size << "B lines, " << store_drain_cycles << " cycles per drain)" << endl;
+	cout << "Stores buffered = " << stats->stores << ", combined = " << stats->combined << ", memory writes = " << stats->drains << endl;
+	cout << "Maximum occupancy = " << stats->max_occupancy << ", buffer full cycles = " << stats->full_cycles << endl;
+	cout << endl;
+}
+
+/* ============================================================================
+
+   Energy model
+
+   =========================================================================== */
+
+void sim_ooo::init_energy_table()
+{
+	static const double events[NUM_ENERGY_EVENTS] = {1.2, 3.0, 1.5, 1.8, 0.8, 1.0, 12.0, 14.0};
+	static const double units[NUM_UNIT_TYPES] = {1.5, 4.0, 12.0, 30.0, 2.0, 16.0, 14.0};
+	static const double leakage[NUM_LEAKAGE_STRUCTURES] = {0.02, 0.03, 0.005, 0.2};
+	memcpy(event_energy, events, sizeof(event_energy));
+	memcpy(unit_energy, units, sizeof(unit_energy));
+	memcpy(leakage_energy, leakage, sizeof(leakage_energy));
+	clock_ghz = 1.0;
+}
+
+/* an operand is read from the register file if no instruction in flight writes it, from the ROB (or from its physical
+   register) if its producer has written the result; otherwise it is captured later from the CDB */
+void sim_ooo::count_issue_events(unsigned pc, bool res_station)
+{
+	instruction_t &instruction = instruction_of(issue_thread, pc);
+	hw_context_t *ctx = &contexts[issue_thread];
+	opcode_t opcode = instruction.opcode;
+	int *tags[NUM_RS_OPERANDS] = {NULL, NULL, NULL};
+	unsigned regs[NUM_RS_OPERANDS] = {instruction.src1, instruction.src2, instruction.src3};
+
+	energy_events[EVENT_ROB_WRITE]++;
+	if (res_station)
+		energy_events[EVENT_RS_WRITE]++;
+	if (is_load(opcode) || is_int_imm(opcode) || (is_branch(opcode) && opcode != JUMP))
+		tags[0] = ctx->INT_tags;
+	else if (is_int_r(opcode) || opcode == MULT || opcode == DIV || opcode == SW)
+		tags[0] = tags[1] = ctx->INT_tags;
+	else if (is_fp_alu(opcode))
+	{
+		tags[0] = tags[1] = ctx->FP_tags;
+		if (opcode == FMAS)
+			tags[2] = ctx->FP_tags;
+	}
+	else if (is_vector_alu(opcode))
+		tags[0] = tags[1] = ctx->V_tags;
+	else if (opcode == SWS || opcode == SWV)
+	{
+		tags[0] = opcode == SWS ? ctx->FP_tags : ctx->V_tags;
+		tags[1] = ctx->INT_tags;
+	}
+	for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
+	{
+		if (tags[k] == NULL)
+			continue;
+		unsigned producer = tags[k][regs[k]];
+		if (producer == UNDEFINED)
+			energy_events[EVENT_RF_READ]++;
+		else if (result_of(producer) != UNDEFINED)
+			energy_events[rob.entries[producer].phys_dest != UNDEFINED ? EVENT_RF_READ : EVENT_ROB_READ]++;
+	}
+}
+
+void sim_ooo::set_event_energy(energy_event_t event, double pj) { event_energy[event] = pj; }
+
+void sim_ooo::set_unit_energy(exe_unit_t unit, double pj) { unit_energy[unit] = pj; }
+
+void sim_ooo::set_leakage(leakage_structure_t structure, double pj) { leakage_energy[structure] = pj; }
+
+void sim_ooo::set_clock_frequency(double ghz)
+{
+	if (ghz <= 0)
+	{
+		cerr << "error: invalid clock frequency " << ghz << " GHz!" << endl;
+		exit(-1);
+	}
+	clock_ghz = ghz;
+}
+
+unsigned long long sim_ooo::get_event_count(energy_event_t event) { return energy_events[event]; }
+
+unsigned long long sim_ooo::get_unit_operations(exe_unit_t unit) { return unit_operations[unit]; }
+
+/* the leakage of each structure is proportional to its number of entries and to the clock cycles; pJ per ns are mW */
+energy_t sim_ooo::get_energy()
+{
+	energy_t energy = {0, 0, 0, 0};
+	unsigned registers = prf_enabled ? prf_size[INT_PRF] + prf_size[FP_PRF] : num_threads * 2 * NUM_GP_REGISTERS;
+	unsigned entries[NUM_LEAKAGE_STRUCTURES] = {rob.num_entries, reservation_stations.num_entries, registers, num_units};
+	for (unsigned e = 0; e < NUM_ENERGY_EVENTS; e++)
+		energy.dynamic += energy_events[e] * event_energy[e];
+	for (unsigned t = 0; t < NUM_UNIT_TYPES; t++)
+		energy.dynamic += unit_operations[t] * unit_energy[t];
+	for (unsigned l = 0; l < NUM_LEAKAGE_STRUCTURES; l++)
+		energy.leakage += (double)entries[l] * leakage_energy[l] * clock_cycles;
+	energy.total = energy.dynamic + energy.leakage;
+	energy.power = clock_cycles ? energy.total * clock_ghz / clock_cycles : 0;
+	return energy;
+}
+
+void sim_ooo::print_energy_stats()
+{
+	energy_t energy = get_energy();
+	unsigned registers = prf_enabled ? prf_size[INT_PRF] + prf_size[FP_PRF] : num_threads * 2 * NUM_GP_REGISTERS;
+	unsigned entries[NUM_LEAKAGE_STRUCTURES] = {rob.num_entries, reservation_stations.num_entries, registers, num_units};
+	streamsize precision = cout.precision();
+	cout << "ENERGY (clock " << fixed << setprecision(2) << clock_ghz << " GHz)" << endl;
+	cout << setfill(' ') << left << setw(18) << "Event" << right << setw(12) << "Count" << setw(10) << "pJ" << setw(13) << "Energy(nJ)" << setw(8) << "Share%" << endl;
+	for (unsigned e = 0; e < NUM_ENERGY_EVENTS; e++)
+	{
+		cout << left << setw(18) << energy_event_names[e] << right << setw(12) << energy_events[e] << setprecision(3) << setw(10) << event_energy[e];
+		cout << setw(13) << energy_events[e] * event_energy[e] / 1000 << setprecision(1) << setw(8) << (energy.total ? 100 * energy_events[e] * event_energy[e] / energy.total : 0.0) << endl;
+	}
+	for (unsigned t = 0; t < NUM_UNIT_TYPES; t++)
+	{
+		if (unit_operations[t] == 0)
+			continue;
+		cout << left << setw(18) << (string(unit_names[t]) + " ops") << right << setw(12) << unit_operations[t] << setprecision(3) << setw(10) << unit_energy[t];
+		cout << setw(13) << unit_operations[t] * unit_energy[t] / 1000 << setprecision(1) << setw(8) << (energy.total ? 100 * unit_operations[t] * unit_energy[t] / energy.total : 0.0) << endl;
+	}
+	for (unsigned l = 0; l < NUM_LEAKAGE_STRUCTURES; l++)
+	{
+		double leakage = (double)entries[l] * leakage_energy[l] * clock_cycles;
+		cout << left << setw(18) << (string("Leakage ") + leakage_names[l]) << right << setw(12) << entries[l] << setprecision(3) << setw(10) << leakage_energy[l];
+		cout << setw(13) << leakage / 1000 << setprecision(1) << setw(8) << (energy.total ? 100 * leakage / energy.total : 0.0) << endl;
+	}
+	cout << "(pJ per event or operation; for leakage, entries and pJ per entry and clock cycle)" << endl;
+	cout << setprecision(3) << "Dynamic energy = " << energy.dynamic / 1000 << " nJ, leakage energy = " << energy.leakage / 1000 << " nJ, total = " << energy.total / 1000 << " nJ" << endl;
+	cout << "Energy per instruction = " << (instructions_executed ? energy.total / instructions_executed : 0.0) << " pJ, average power = " << energy.power << " mW" << endl;
+	cout.unsetf(ios::floatfield);
+	cout.precision(precision);
+	cout << endl;
+}
+
+/* ============================================================================
+
+   Vector instructions
+
+   =========================================================================== */
+
+/* a vector result travels on the CDB as a 0 in the scalar value, so that the readiness checks on the scalar
+   fields also cover the vector operands; the lanes travel next to it */
+void sim_ooo::read_vector_operand(unsigned reg, unsigned *lanes, unsigned *value, rs_tag_t *tag)
+{
+	hw_context_t *ctx = &contexts[issue_thread];
+	unsigned producer = ctx->V_tags[reg];
+	if (producer == UNDEFINED)
+	{
+		for (unsigned l = 0; l < VECTOR_LANES; l++)
+			lanes[l] = float2unsigned(ctx->V_regs[reg][l]);
+		*value = 0;
+	}
+	else if (rob.entries[producer].value != UNDEFINED)
+	{
+		memcpy(lanes, rob.entries[producer].vector_value, sizeof(rob.entries[producer].vector_value));
+		*value = 0;
+	}
+	else
+		*tag = producer;
+}
+
+/* ============================================================================
+
+   Reservation station tags
+
+   =========================================================================== */
+
+void sim_ooo::enable_simd(bool enable)
+{
+	simd_enabled = enable;
+}
 
-	//rob, instruction window, reservation stations
-	rob.num_entries = rob_size;
-	pending_instructions.num_entries = rob_size;
-	reservation_stations.num_entries = num_int_res_stations + num_load_res_stations + num_add_res_stations + num_mul_res_stations;
-	rob.entries = new rob_entry_t[rob_size];
-	pending_instructions.entries = new instr_window_entry_t[rob_size];
-	reservation_stations.entries = new res_station_entry_t[reservation_stations.num_entries];
-	unsigned n = 0;
-	for (unsigned i = 0; i < num_int_res_stations; i++, n++)
+#if defined(__x86_64__) || defined(__i386__)
+/* 32 tags per iteration; only called if the host supports AVX2 */
+__attribute__((target("avx2"))) static void match_tags_avx2(const rs_tag_t *tags, unsigned slots, rs_tag_t tag, unsigned long long *matches)
+{
+	__m256i key = _mm256_set1_epi16((short)tag);
+	for (unsigned i = 0; i < slots; i += 32)
 	{
-		reservation_stations.entries[n].type = INTEGER_RS;
-		reservation_stations.entries[n].name = i;
+		__m256i low = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(tags + i)), key);
+		__m256i high = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *)(tags + i + 16)), key);
+		//packing interleaves the 128-bit halves of the two compares: restore the order of the tags
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xD8);
+		unsigned long long mask = (unsigned)_mm256_movemask_epi8(packed);
+		if (i % 64 == 0)
+			matches[i / 64] = mask;
+		else
+			matches[i / 64] |= mask << 32;
 	}
-	for (unsigned i = 0; i < num_load_res_stations; i++, n++)
+}
+
+/* 16 tags per iteration (SSE2 is always available on x86-64) */
+static void match_tags_sse2(const rs_tag_t *tags, unsigned slots, rs_tag_t tag, unsigned long long *matches)
+{
+	__m128i key = _mm_set1_epi16((short)tag);
+	for (unsigned i = 0; i < slots; i += 16)
 	{
-		reservation_stations.entries[n].type = LOAD_B;
-		reservation_stations.entries[n].name = i;
+		__m128i low = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(tags + i)), key);
+		__m128i high = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(tags + i + 8)), key);
+		unsigned long long mask = (unsigned)_mm_movemask_epi8(_mm_packs_epi16(low, high));
+		if (i % 64 == 0)
+			matches[i / 64] = mask;
+		else
+			matches[i / 64] |= mask << (i % 64);
 	}
-	for (unsigned i = 0; i < num_add_res_stations; i++, n++)
+}
+#endif
+
+static void match_tags_scalar(const rs_tag_t *tags, unsigned slots, rs_tag_t tag, unsigned long long *matches)
+{
+	for (unsigned w = 0; w < slots / 64; w++)
 	{
-		reservation_stations.entries[n].type = ADD_RS;
-		reservation_stations.entries[n].name = i;
+		unsigned long long mask = 0;
+		for (unsigned b = 0; b < 64; b++)
+			mask |= (unsigned long long)(tags[w * 64 + b] == tag) << b;
+		matches[w] = mask;
 	}
-	for (unsigned i = 0; i < num_mul_res_stations; i++, n++)
+}
+
+void sim_ooo::match_tags(unsigned operand, rs_tag_t tag, unsigned long long *matches)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool has_avx2 = __builtin_cpu_supports("avx2");
+	if (simd_enabled && has_avx2)
+		match_tags_avx2(rs_tags[operand], rs_slots, tag, matches);
+	else if (simd_enabled)
+		match_tags_sse2(rs_tags[operand], rs_slots, tag, matches);
+	else
+#endif
+		match_tags_scalar(rs_tags[operand], rs_slots, tag, matches);
+}
+
+/* an operand is available when its tag is NO_TAG */
+void sim_ooo::find_ready()
+{
+	memcpy(rs_ready, rs_valid, rs_slots / 64 * sizeof(unsigned long long));
+	for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
 	{
-		reservation_stations.entries[n].type = MULT_RS;
-		reservation_stations.entries[n].name = i;
+		match_tags(k, NO_TAG, rs_match);
+		for (unsigned w = 0; w < rs_slots / 64; w++)
+			rs_ready[w] &= rs_match[w];
 	}
-	//execution units
-	num_units = 0;
-	reset();
 }
 
-sim_ooo::~sim_ooo()
+void sim_ooo::free_res_station(unsigned index)
 {
-	delete[] data_memory;
-	delete[] rob.entries;
-	delete[] pending_instructions.entries;
-	delete[] reservation_stations.entries;
+	clean_res_station(&reservation_stations.entries[index]);
+	for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
+		rs_tags[k][index] = NO_TAG;
+	rs_valid[index / 64] &= ~(1ULL << (index % 64));
+}
+
+void sim_ooo::broadcast(unsigned tag, unsigned value, const unsigned *lanes)
+{
+	energy_events[EVENT_CDB_BROADCAST]++;
+	for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
+	{
+		match_tags(k, tag, rs_match);
+		for (unsigned w = 0; w < rs_slots / 64; w++)
+		{
+			for (unsigned long long bits = rs_match[w]; bits != 0; bits &= bits - 1)
+			{
+				res_station_entry_t *entry = &reservation_stations.entries[w * 64 + __builtin_ctzll(bits)];
+				rs_tags[k][w * 64 + __builtin_ctzll(bits)] = NO_TAG;
+				energy_events[EVENT_RS_WRITE]++;
+				if (k == 0)
+					entry->value1 = value;
+				else if (k == 1)
+					entry->value2 = value;
+				else
+					entry->value3 = value;
+				if (lanes != NULL && k < 2)
+					memcpy(k == 0 ? entry->vector1 : entry->vector2, lanes, VECTOR_LANES * sizeof(unsigned));
+			}
+		}
+	}
 }
 
 /* =============================================================
@@ -748,16 +2832,54 @@ sim_ooo::~sim_ooo()
 
    ============================================================= */
 
-/* core of the simulator */
-void sim_ooo::run(unsigned cycles)
+/* core of the simulator: simulates one clock cycle */
+void sim_ooo::step()
 {
 	issue_struct_stall = false; // resetting the struct hazard flag
 	int issue_counter = issue_width;
-	bool willBranch = false;
-	int loadReleasedUnit = 99;
-	cout << "\nPC is:" << PC << "\n";
+	unsigned loadReleasedUnit = 99;
+	int ROBindex4ResStations = 0;
+	bool vacantPlace;
+	bool eliminated; // the instruction is resolved at rename (move elimination)
+	unsigned eliminated_value;
+	bool zero_idiom;
+	bool committed[MAX_THREADS]; // one instruction per thread commits in each clock cycle
+
+	//the issue stage works on the context of the selected thread
+	for (unsigned t = 0; t < num_threads; t++)
+	{
+		contexts[t].will_branch = false;
+		committed[t] = false;
+	}
+	issue_thread = select_thread();
+	hw_context_t *ctx = &contexts[issue_thread];
+	unsigned &PC = ctx->PC;
+	int *INT_regs = ctx->INT_regs;
+	float *FP_regs = ctx->FP_regs;
+	int *INT_tags = ctx->INT_tags;
+	int *FP_tags = ctx->FP_tags;
+	instruction_t *instr_memory = ctx->instr_memory;
+	unsigned instr_base_address = ctx->instr_base_address;
+	unsigned &ROBentryIndex = partitioned_rob ? ctx->rob_next : rob_next;
+	TRACE("\nPC is:" << PC << "\n");
 
 ISSUE_STAGE:
+	eliminated = elimination_enabled && eliminate(PC, &eliminated_value, &zero_idiom);
+
+	//macro-op fusion: the pair takes one issue slot, and PC moves to its second instruction
+	if (fusion_enabled && !eliminated && instr_memory[(PC - instr_base_address) / 0x00000004].fuse_next && can_fuse(PC))
+	{
+		if (issue_fused_pair(PC))
+			PC += 0x00000004;
+		else
+		{
+			issue_struct_stall = true;
+			issue_stall_cause = STALL_RS_FULL;
+			issue_stall_pc = PC;
+		}
+		goto ISSUE_DONE;
+	}
+
 	//detecting if the reservation station is full or not
 	vacantPlace = false; //if it turns true then there's a vacant place in the Reservation station
 						 //Checking the reservation stations without adding anything to them first
@@ -774,10 +2896,12 @@ ISSUE_STAGE:
 		if (vacantPlace == false)
 		{
 			issue_struct_stall = true;
+			issue_stall_cause = STALL_RS_FULL;
+			issue_stall_pc = PC;
 		}
 	}
 
-	if (is_int(instr_memory[(PC - instr_base_address) / 0x00000004].opcode))
+	if (is_int(instr_memory[(PC - instr_base_address) / 0x00000004].opcode) && !eliminated)
 	{
 		for (int i = 0; i < reservation_stations.num_entries; i++)
 		{
@@ -790,6 +2914,8 @@ ISSUE_STAGE:
 		if (vacantPlace == false)
 		{
 			issue_struct_stall = true;
+			issue_stall_cause = STALL_RS_FULL;
+			issue_stall_pc = PC;
 		}
 	}
 
@@ -806,6 +2932,8 @@ ISSUE_STAGE:
 		if (vacantPlace == false)
 		{
 			issue_struct_stall = true;
+			issue_stall_cause = STALL_RS_FULL;
+			issue_stall_pc = PC;
 		}
 	}
 
@@ -822,10 +2950,12 @@ ISSUE_STAGE:
 		if (vacantPlace == false)
 		{
 			issue_struct_stall = true;
+			issue_stall_cause = STALL_RS_FULL;
+			issue_stall_pc = PC;
 		}
 	}
 
-	if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == MULTS || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == DIVS)
+	if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == MULTS || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == DIVS || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == FMAS)
 	{
 		for (int i = 0; i < reservation_stations.num_entries; i++)
 		{
@@ -838,61 +2968,120 @@ ISSUE_STAGE:
 		if (vacantPlace == false)
 		{
 			issue_struct_stall = true;
+			issue_stall_cause = STALL_RS_FULL;
+			issue_stall_pc = PC;
+		}
+	}
+
+	if (is_vector_alu(instr_memory[(PC - instr_base_address) / 0x00000004].opcode))
+	{
+		for (unsigned i = 0; i < reservation_stations.num_entries; i++)
+		{
+			if (reservation_stations.entries[i].type == VECTOR_RS && reservation_stations.entries[i].pc == UNDEFINED)
+			{
+				vacantPlace = true;
+				break;
+			}
+		}
+		if (vacantPlace == false)
+		{
+			issue_struct_stall = true;
+			issue_stall_cause = STALL_RS_FULL;
+			issue_stall_pc = PC;
+		}
+	}
+
+	//merged register file mode: the destination needs a free physical register
+	if (prf_enabled && issue_struct_stall == false && writes_register(instr_memory[(PC - instr_base_address) / 0x00000004].opcode))
+	{
+		unsigned k = is_fp_alu(instr_memory[(PC - instr_base_address) / 0x00000004].opcode) || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == LWS ? FP_PRF : INT_PRF;
+		if (free_count[k] == 0)
+		{
+			issue_struct_stall = true;
+			issue_stall_cause = STALL_PRF_FULL;
+			issue_stall_pc = PC;
+			prf_stall_cycles[k]++;
 		}
 	}
 
+	//decoupled front-end: the instruction must be at the head of the fetch queue and decoded
+	if (frontend_enabled && issue_struct_stall == false && instr_memory[(PC - instr_base_address) / 0x00000004].opcode != EOP && !fetched(issue_thread, PC))
+	{
+		issue_struct_stall = true;
+		issue_stall_cause = STALL_FETCH;
+		issue_stall_pc = PC;
+		frontend_stats.starved_cycles++;
+	}
+
 	//Issue stage
 	if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode != EOP && issue_struct_stall == false)
 	{
-		if (ROBentryIndex == rob.num_entries)
+		if (ROBentryIndex == ctx->rob_end)
 		{
-			ROBentryIndex = 0;
+			ROBentryIndex = ctx->rob_start;
 		}
 		if (rob.entries[ROBentryIndex].pc == UNDEFINED)
 		{
 			rob.entries[ROBentryIndex].pc = PC;
+			rob.entries[ROBentryIndex].thread = issue_thread;
 			if (is_fp_alu(instr_memory[(PC - instr_base_address) / 0x00000004].opcode) || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == LWS)
 			{
 				rob.entries[ROBentryIndex].destination = instr_memory[(PC - instr_base_address) / 0x00000004].dest + NUM_GP_REGISTERS;
 			}
+			else if (is_vector_alu(instr_memory[(PC - instr_base_address) / 0x00000004].opcode) || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == LWV)
+			{
+				rob.entries[ROBentryIndex].destination = instr_memory[(PC - instr_base_address) / 0x00000004].dest + 2 * NUM_GP_REGISTERS;
+			}
 			else
 			{
 				rob.entries[ROBentryIndex].destination = instr_memory[(PC - instr_base_address) / 0x00000004].dest;
 			}
 			rob.entries[ROBentryIndex].state = ISSUE;
 			rob.entries[ROBentryIndex].value = UNDEFINED;
+			rob.entries[ROBentryIndex].seq = issue_sequence++;
+			count_issue_events(PC, !eliminated);
+			if (frontend_enabled)
+				pop_fetch_queue(issue_thread);
+			rob.entries[ROBentryIndex].predicted_pc = next_issue_pc(PC);
+			if (prf_enabled)
+				allocate_register(ROBentryIndex);
 			ROBindex4ResStations = ROBentryIndex;
 			pending_instructions.entries[ROBentryIndex].pc = PC;
+			pending_instructions.entries[ROBentryIndex].thread = issue_thread;
 			pending_instructions.entries[ROBentryIndex].issue = clock_cycles;
 			ROBentryIndex++;
 		}
 		else if (rob.entries[ROBentryIndex].pc != UNDEFINED)
 		{
 			issue_struct_stall = true; //full ROB detected, a stall is needed
+			issue_stall_cause = STALL_ROB_FULL;
+			issue_stall_pc = PC;
 		}
 
 		if (issue_struct_stall == false)
 		{
-			if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == LW || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == LWS)
+			if (is_load(instr_memory[(PC - instr_base_address) / 0x00000004].opcode))
 			{
 				for (int i = 0; i < reservation_stations.num_entries; i++)
 				{
 					if (reservation_stations.entries[i].type == LOAD_B && reservation_stations.entries[i].pc == UNDEFINED)
 					{
 						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
 						reservation_stations.entries[i].address = instr_memory[(PC - instr_base_address) / 0x00000004].immediate;
 						reservation_stations.entries[i].destination = ROBindex4ResStations;
 						if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value1 = INT_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value != UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value;
+							reservation_stations.entries[i].value1 = result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value == UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag1 = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
+							rs_tags[0][i] = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
 						if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == LWS)
 						{
@@ -902,6 +3091,10 @@ ISSUE_STAGE:
 						{
 							INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].dest] = ROBindex4ResStations;
 						}
+						else
+						{
+							ctx->V_tags[instr_memory[(PC - instr_base_address) / 0x00000004].dest] = ROBindex4ResStations;
+						}
 						break;
 					}
 				}
@@ -915,6 +3108,8 @@ ISSUE_STAGE:
 					if (reservation_stations.entries[i].type == LOAD_B && reservation_stations.entries[i].pc == UNDEFINED)
 					{
 						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
 						reservation_stations.entries[i].address = instr_memory[(PC - instr_base_address) / 0x00000004].immediate;
 						reservation_stations.entries[i].destination = ROBindex4ResStations;
 						//source 1 is FP (value to be inserted in memory)
@@ -922,64 +3117,128 @@ ISSUE_STAGE:
 						{
 							reservation_stations.entries[i].value1 = float2unsigned(FP_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value != UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value;
+							reservation_stations.entries[i].value1 = result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value == UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag1 = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
+							rs_tags[0][i] = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
 						//source 2
 						if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value2 = INT_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value != UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) != UNDEFINED)
+						{
+							reservation_stations.entries[i].value2 = result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]);
+						}
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) == UNDEFINED)
+						{
+							rs_tags[1][i] = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
+						}
+						break;
+					}
+				}
+			}
+
+			if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == SWV)
+			{
+				for (unsigned i = 0; i < reservation_stations.num_entries; i++)
+				{
+					if (reservation_stations.entries[i].type == LOAD_B && reservation_stations.entries[i].pc == UNDEFINED)
+					{
+						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
+						reservation_stations.entries[i].address = instr_memory[(PC - instr_base_address) / 0x00000004].immediate;
+						reservation_stations.entries[i].destination = ROBindex4ResStations;
+						//source 1 is a vector (lanes to be written to memory)
+						read_vector_operand(instr_memory[(PC - instr_base_address) / 0x00000004].src1, reservation_stations.entries[i].vector1, &reservation_stations.entries[i].value1, &rs_tags[0][i]);
+						//source 2
+						if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] == (int)UNDEFINED)
+						{
+							reservation_stations.entries[i].value2 = INT_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
+						}
+						else if (result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value2 = rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value;
+							reservation_stations.entries[i].value2 = result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]);
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value == UNDEFINED)
+						else
 						{
-							reservation_stations.entries[i].tag2 = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
+							rs_tags[1][i] = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
 						}
 						break;
 					}
 				}
 			}
 
-			if (is_int_r(instr_memory[(PC - instr_base_address) / 0x00000004].opcode))
+			if (is_vector_alu(instr_memory[(PC - instr_base_address) / 0x00000004].opcode))
+			{
+				for (unsigned i = 0; i < reservation_stations.num_entries; i++)
+				{
+					if (reservation_stations.entries[i].type == VECTOR_RS && reservation_stations.entries[i].pc == UNDEFINED)
+					{
+						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
+						reservation_stations.entries[i].destination = ROBindex4ResStations;
+						read_vector_operand(instr_memory[(PC - instr_base_address) / 0x00000004].src1, reservation_stations.entries[i].vector1, &reservation_stations.entries[i].value1, &rs_tags[0][i]);
+						read_vector_operand(instr_memory[(PC - instr_base_address) / 0x00000004].src2, reservation_stations.entries[i].vector2, &reservation_stations.entries[i].value2, &rs_tags[1][i]);
+						ctx->V_tags[instr_memory[(PC - instr_base_address) / 0x00000004].dest] = ROBindex4ResStations;
+						break;
+					}
+				}
+			}
+
+			//eliminated instructions write their result at issue, without a reservation station or an execution unit
+			if (eliminated)
+			{
+				write_result(ROBindex4ResStations, eliminated_value);
+				rob.entries[ROBindex4ResStations].state = WRITE_RESULT;
+				pending_instructions.entries[ROBindex4ResStations].wr = clock_cycles;
+				INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].dest] = ROBindex4ResStations;
+				if (zero_idiom)
+					eliminated_zero_idioms++;
+				else
+					eliminated_moves++;
+			}
+
+			if (is_int_r(instr_memory[(PC - instr_base_address) / 0x00000004].opcode) && !eliminated)
 			{
 				for (int i = 0; i < reservation_stations.num_entries; i++)
 				{
 					if (reservation_stations.entries[i].type == INTEGER_RS && reservation_stations.entries[i].pc == UNDEFINED)
 					{
 						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
 						reservation_stations.entries[i].destination = ROBindex4ResStations;
 						if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value1 = INT_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value != UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value;
+							reservation_stations.entries[i].value1 = result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value == UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag1 = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
+							rs_tags[0][i] = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
 						//value 2
 						if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value2 = INT_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value != UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value;
+							reservation_stations.entries[i].value1 = result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]);
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value == UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag2 = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
+							rs_tags[1][i] = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
 						}
 						if ((instr_memory[(PC - instr_base_address) / 0x00000004].src2 == instr_memory[(PC - instr_base_address) / 0x00000004].src1) && reservation_stations.entries[i].value1 != UNDEFINED)
 						{
@@ -991,25 +3250,27 @@ ISSUE_STAGE:
 				}
 			}
 
-			if (is_int_imm(instr_memory[(PC - instr_base_address) / 0x00000004].opcode))
+			if (is_int_imm(instr_memory[(PC - instr_base_address) / 0x00000004].opcode) && !eliminated)
 			{
 				for (int i = 0; i < reservation_stations.num_entries; i++)
 				{
 					if (reservation_stations.entries[i].type == INTEGER_RS && reservation_stations.entries[i].pc == UNDEFINED)
 					{
 						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
 						reservation_stations.entries[i].destination = ROBindex4ResStations;
 						if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value1 = INT_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value != UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value;
+							reservation_stations.entries[i].value1 = result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value == UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag1 = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
+							rs_tags[0][i] = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
 						INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].dest] = ROBindex4ResStations;
 						break;
@@ -1024,17 +3285,19 @@ ISSUE_STAGE:
 					if (reservation_stations.entries[i].type == INTEGER_RS && reservation_stations.entries[i].pc == UNDEFINED)
 					{
 						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
 						if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value1 = INT_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value != UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value;
+							reservation_stations.entries[i].value1 = result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value == UNDEFINED)
+						else if (INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag1 = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
+							rs_tags[0][i] = INT_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
 						reservation_stations.entries[i].destination = ROBindex4ResStations;
 						break;
@@ -1049,31 +3312,33 @@ ISSUE_STAGE:
 					if (reservation_stations.entries[i].type == ADD_RS && reservation_stations.entries[i].pc == UNDEFINED)
 					{
 						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
 						reservation_stations.entries[i].destination = ROBindex4ResStations;
 						if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value1 = float2unsigned(FP_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value != UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value;
+							reservation_stations.entries[i].value1 = result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value == UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag1 = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
+							rs_tags[0][i] = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
 						//value 2
 						if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value2 = float2unsigned(FP_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src2]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value != UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value2 = rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value;
+							reservation_stations.entries[i].value2 = result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value == UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag2 = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
+							rs_tags[1][i] = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
 						}
 						FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].dest] = ROBindex4ResStations;
 						break;
@@ -1081,38 +3346,56 @@ ISSUE_STAGE:
 				}
 			}
 
-			if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == MULTS || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == DIVS)
+			if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == MULTS || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == DIVS || instr_memory[(PC - instr_base_address) / 0x00000004].opcode == FMAS)
 			{
 				for (int i = 0; i < reservation_stations.num_entries; i++)
 				{
 					if (reservation_stations.entries[i].type == MULT_RS && reservation_stations.entries[i].pc == UNDEFINED)
 					{
 						reservation_stations.entries[i].pc = PC;
+						rs_valid[i / 64] |= 1ULL << (i % 64);
+						reservation_stations.entries[i].thread = issue_thread;
 						reservation_stations.entries[i].destination = ROBindex4ResStations;
 						if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value1 = float2unsigned(FP_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value != UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) != UNDEFINED)
 						{
-							reservation_stations.entries[i].value1 = rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value;
+							reservation_stations.entries[i].value1 = result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]].value == UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].tag1 = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
+							rs_tags[0][i] = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src1];
 						}
 						//value 2
 						if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] == UNDEFINED)
 						{
 							reservation_stations.entries[i].value2 = float2unsigned(FP_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src2]);
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value != UNDEFINED)
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) != UNDEFINED)
+						{
+							reservation_stations.entries[i].value2 = result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]);
+						}
+						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]) == UNDEFINED)
 						{
-							reservation_stations.entries[i].value2 = rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value;
+							rs_tags[1][i] = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
 						}
-						else if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2] != UNDEFINED && rob.entries[FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2]].value == UNDEFINED)
+						//value 3 (FMAS addend)
+						if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode == FMAS)
 						{
-							reservation_stations.entries[i].tag2 = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src2];
+							if (FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src3] == (int)UNDEFINED)
+							{
+								reservation_stations.entries[i].value3 = float2unsigned(FP_regs[instr_memory[(PC - instr_base_address) / 0x00000004].src3]);
+							}
+							else if (result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src3]) != UNDEFINED)
+							{
+								reservation_stations.entries[i].value3 = result_of(FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src3]);
+							}
+							else
+							{
+								rs_tags[2][i] = FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].src3];
+							}
 						}
 						FP_tags[instr_memory[(PC - instr_base_address) / 0x00000004].dest] = ROBindex4ResStations;
 						break;
@@ -1121,25 +3404,26 @@ ISSUE_STAGE:
 			}
 		}
 	}
+ISSUE_DONE:
 	issue_counter--;
-	if (issue_counter > 0 && issue_struct_stall == false && instr_memory[(PC - instr_base_address + 0x00000004) / 0x00000004].opcode != EOP)
+	if (issue_counter > 0 && issue_struct_stall == false && instr_memory[(PC - instr_base_address) / 0x00000004].opcode != EOP && instr_memory[(next_issue_pc(PC) - instr_base_address) / 0x00000004].opcode != EOP)
 	{
-		PC += 0x00000004;
+		PC = next_issue_pc(PC);
 		goto ISSUE_STAGE;
 	}
 
 	//Execution Stage
-	cout << "Entering EX";
+	TRACE("Entering EX");
 	//EX stage for STORE section
 	for (int i = 0; i < reservation_stations.num_entries; i++)
 	{ //checking for available execution units
 		if (reservation_stations.entries[i].destination != UNDEFINED)
 		{
-			if (pending_instructions.entries[reservation_stations.entries[i].destination].issue < clock_cycles && rob.entries[reservation_stations.entries[i].destination].state == ISSUE && reservation_stations.entries[i].tag1 == UNDEFINED && reservation_stations.entries[i].tag2 == UNDEFINED && instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode == SWS)
+			if (pending_instructions.entries[reservation_stations.entries[i].destination].issue < clock_cycles && rob.entries[reservation_stations.entries[i].destination].state == ISSUE && rs_tags[0][i] == NO_TAG && rs_tags[1][i] == NO_TAG && is_store(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode))
 			{
 				if (pending_instructions.entries[reservation_stations.entries[i].destination].issue < clock_cycles)
 				{
-					rob.entries[reservation_stations.entries[i].destination].destination = instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].immediate + reservation_stations.entries[i].value2;
+					rob.entries[reservation_stations.entries[i].destination].destination = instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).immediate + reservation_stations.entries[i].value2;
 					reservation_stations.entries[i].address = rob.entries[reservation_stations.entries[i].destination].destination;
 					rob.entries[reservation_stations.entries[i].destination].state = EXECUTE;
 					pending_instructions.entries[reservation_stations.entries[i].destination].exe = clock_cycles;
@@ -1149,27 +3433,39 @@ ISSUE_STAGE:
 	}
 
 	//End of STORE execution and beginning of Other Execution stage
-	for (int i = 0; i < reservation_stations.num_entries; i++)
+	//(the ready instructions compete for the execution units in the order chosen by the select policy)
+	if (select_policy != SELECT_POSITION)
+		schedule();
+	find_ready();
+	for (unsigned k = 0; k < reservation_stations.num_entries; k++)
 	{ //checking for available execution units
-		if (reservation_stations.entries[i].pc < PC && rob.entries[reservation_stations.entries[i].destination].state == ISSUE && get_free_unit(instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode) != UNDEFINED && reservation_stations.entries[i].tag1 == UNDEFINED && reservation_stations.entries[i].tag2 == UNDEFINED && instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode != SWS)
+		unsigned i = select_policy == SELECT_POSITION ? k : select_order[k];
+		if ((rs_ready[i / 64] >> (i % 64) & 1) && rob.entries[reservation_stations.entries[i].destination].state == ISSUE && get_free_unit(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode) != UNDEFINED && !is_store(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode))
 		{
 			if (pending_instructions.entries[reservation_stations.entries[i].destination].issue < clock_cycles)
 			{
-				int theExecUnitNum = get_free_unit(instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode); //saving the free execution unit's index number
-				exec_units[theExecUnitNum].ALUoutput = alu(instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode, reservation_stations.entries[i].value1, reservation_stations.entries[i].value2, instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].immediate, reservation_stations.entries[i].pc);
-				if (instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode == LWS || instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode == LW)
+				int theExecUnitNum = get_free_unit(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode); //saving the free execution unit's index number
+				exec_units[theExecUnitNum].ALUoutput = alu(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode, reservation_stations.entries[i].value1, reservation_stations.entries[i].value2, instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).immediate, reservation_stations.entries[i].pc);
+				if (instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode == FMAS)
+					exec_units[theExecUnitNum].ALUoutput = fma_alu(reservation_stations.entries[i].value1, reservation_stations.entries[i].value2, reservation_stations.entries[i].value3);
+				if (is_vector_alu(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode))
+				{
+					vector_alu(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode, reservation_stations.entries[i].vector1, reservation_stations.entries[i].vector2, exec_units[theExecUnitNum].vector_output);
+					exec_units[theExecUnitNum].ALUoutput = 0;
+				}
+				if (is_load(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode))
 				{
 					for (int j = 0; j < reservation_stations.num_entries; j++)
 					{
 						if (reservation_stations.entries[j].pc != UNDEFINED)
 						{
-							if (instr_memory[(reservation_stations.entries[j].pc - instr_base_address) / 0x00000004].opcode == SWS && reservation_stations.entries[j].pc < reservation_stations.entries[i].pc)
+							if (is_store(instruction_of(reservation_stations.entries[j].thread, reservation_stations.entries[j].pc).opcode) && reservation_stations.entries[j].thread == reservation_stations.entries[i].thread && rob.entries[reservation_stations.entries[j].destination].seq < rob.entries[reservation_stations.entries[i].destination].seq)
 							{
-								if ((reservation_stations.entries[j].tag2 == UNDEFINED && rob.entries[reservation_stations.entries[j].destination].state == ISSUE && reservation_stations.entries[j].value2 + reservation_stations.entries[j].address == reservation_stations.entries[i].value1 + reservation_stations.entries[i].address) || (rob.entries[reservation_stations.entries[j].destination].state != ISSUE && reservation_stations.entries[j].address == reservation_stations.entries[i].value1 + reservation_stations.entries[i].address))
+								if ((rs_tags[1][j] == NO_TAG && rob.entries[reservation_stations.entries[j].destination].state == ISSUE && accesses_overlap(instruction_of(reservation_stations.entries[j].thread, reservation_stations.entries[j].pc).opcode, reservation_stations.entries[j].value2 + reservation_stations.entries[j].address, instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode, reservation_stations.entries[i].value1 + reservation_stations.entries[i].address)) || (rob.entries[reservation_stations.entries[j].destination].state != ISSUE && accesses_overlap(instruction_of(reservation_stations.entries[j].thread, reservation_stations.entries[j].pc).opcode, reservation_stations.entries[j].address, instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode, reservation_stations.entries[i].value1 + reservation_stations.entries[i].address)))
 								{
 									goto RAW_MEM_STALL;
 								}
-								if (reservation_stations.entries[j].tag2 != UNDEFINED)
+								if (rs_tags[1][j] != NO_TAG)
 								{
 									goto RAW_MEM_STALL;
 								}
@@ -1181,9 +3477,9 @@ ISSUE_STAGE:
 					{
 						if (rob.entries[j].pc != UNDEFINED)
 						{
-							if (instr_memory[(rob.entries[j].pc - instr_base_address) / 0x00000004].opcode == SWS && rob.entries[j].pc < reservation_stations.entries[i].pc)
+							if (is_store(instruction_of(rob.entries[j].thread, rob.entries[j].pc).opcode) && rob.entries[j].thread == reservation_stations.entries[i].thread && rob.entries[j].seq < rob.entries[reservation_stations.entries[i].destination].seq)
 							{
-								if (rob.entries[j].destination == reservation_stations.entries[i].value1 + reservation_stations.entries[i].address && (rob.entries[j].state == WRITE_RESULT || rob.entries[j].state == COMMIT))
+								if (accesses_overlap(instruction_of(rob.entries[j].thread, rob.entries[j].pc).opcode, rob.entries[j].destination, instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode, reservation_stations.entries[i].value1 + reservation_stations.entries[i].address) && (rob.entries[j].state == WRITE_RESULT || rob.entries[j].state == COMMIT))
 								{
 									goto RAW_MEM_STALL;
 								}
@@ -1191,15 +3487,32 @@ ISSUE_STAGE:
 						}
 					}
 
-					unsigned char *dataptr = &data_memory[reservation_stations.entries[i].value1 + reservation_stations.entries[i].address];
 					reservation_stations.entries[i].address = reservation_stations.entries[i].value1 + reservation_stations.entries[i].address;
-					exec_units[theExecUnitNum].ALUoutput = char2unsigned(dataptr);
+					unsigned address = reservation_stations.entries[i].address;
+					if (instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode == LWV)
+					{
+						for (unsigned l = 0; l < VECTOR_LANES; l++)
+							exec_units[theExecUnitNum].vector_output[l] = load_word(address + 4 * l);
+						exec_units[theExecUnitNum].ALUoutput = 0;
+					}
+					else
+						exec_units[theExecUnitNum].ALUoutput = load_word(address);
 				}
 				exec_units[theExecUnitNum].pc = reservation_stations.entries[i].pc;
+				exec_units[theExecUnitNum].res_station = i;
+				exec_units[theExecUnitNum].rob_entry = reservation_stations.entries[i].destination;
+				exec_units[theExecUnitNum].thread = reservation_stations.entries[i].thread;
 				rob.entries[reservation_stations.entries[i].destination].state = EXECUTE;
 				pending_instructions.entries[reservation_stations.entries[i].destination].exe = clock_cycles;
-				cout << "Past pc assignment";
+				if (reservation_stations.entries[i].fused_destination != UNDEFINED)
+					start_fused(i);
+				TRACE("Past pc assignment");
 				exec_units[theExecUnitNum].busy = exec_units[theExecUnitNum].latency;
+				unit_operations[exec_units[theExecUnitNum].type]++;
+				if (is_load(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode))
+					energy_events[EVENT_MEM_READ]++;
+				if (hierarchy != NULL && is_load(instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode))
+					exec_units[theExecUnitNum].busy += hierarchy->access(core_id, reservation_stations.entries[i].address, false, clock_cycles, reservation_stations.entries[i].pc);
 			}
 		RAW_MEM_STALL:;
 		}
@@ -1211,57 +3524,64 @@ ISSUE_STAGE:
 	{
 		if (reservation_stations.entries[i].pc != UNDEFINED)
 		{
-			if ((instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode == LWS || instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode == LW) && rob.entries[reservation_stations.entries[i].destination].state == ISSUE && reservation_stations.entries[i].tag1 == UNDEFINED && pending_instructions.entries[reservation_stations.entries[i].destination].issue < clock_cycles)
+			if ((instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode == LWS || instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode == LW) && rob.entries[reservation_stations.entries[i].destination].state == ISSUE && rs_tags[0][i] == NO_TAG && pending_instructions.entries[reservation_stations.entries[i].destination].issue < clock_cycles)
 			{
-				for (int j = 0; j < rob.num_entries; j++)
+				//vector stores are not forwarded: the load waits for an older overlapping one to leave the ROB
+				bool vector_store = false;
+				for (unsigned j = 0; j < rob.num_entries; j++)
+					if (rob.entries[j].pc != UNDEFINED && instruction_of(rob.entries[j].thread, rob.entries[j].pc).opcode == SWV && rob.entries[j].thread == reservation_stations.entries[i].thread && rob.entries[j].seq < rob.entries[reservation_stations.entries[i].destination].seq && (rob.entries[j].state == ISSUE || accesses_overlap(SWV, rob.entries[j].destination, LW, reservation_stations.entries[i].value1 + reservation_stations.entries[i].address)))
+						vector_store = true;
+				//the value is forwarded by the youngest older store to the address
+				unsigned store = UNDEFINED;
+				for (unsigned j = 0; j < rob.num_entries && !vector_store; j++)
 				{
 					if (rob.entries[j].pc != UNDEFINED)
 					{
-						if (instr_memory[(rob.entries[j].pc - instr_base_address) / 0x00000004].opcode == SWS && (rob.entries[j].state == WRITE_RESULT || rob.entries[j].state == COMMIT) && rob.entries[j].destination == reservation_stations.entries[i].value1 + reservation_stations.entries[i].address)
+						if (instruction_of(rob.entries[j].thread, rob.entries[j].pc).opcode == SWS && rob.entries[j].thread == reservation_stations.entries[i].thread && rob.entries[j].seq < rob.entries[reservation_stations.entries[i].destination].seq && (rob.entries[j].state == WRITE_RESULT || rob.entries[j].state == COMMIT) && rob.entries[j].destination == reservation_stations.entries[i].value1 + reservation_stations.entries[i].address)
 						{
-							reservation_stations.entries[i].address = reservation_stations.entries[i].address + reservation_stations.entries[i].value1;
-							rob.entries[reservation_stations.entries[i].destination].state = EXECUTE;
-							reservation_stations.entries[i].value2 = rob.entries[j].value;
-							rob.entries[reservation_stations.entries[i].destination].store_bypassed = true;
-							pending_instructions.entries[reservation_stations.entries[i].destination].exe = clock_cycles;
+							if (store == UNDEFINED || rob.entries[j].seq > rob.entries[store].seq)
+								store = j;
 						}
 					}
 				}
+				//not past a younger store whose address is unknown or overlapping, and whose value is still pending
+				for (unsigned j = 0; j < rob.num_entries && store != UNDEFINED; j++)
+					if (rob.entries[j].pc != UNDEFINED && is_store(instruction_of(rob.entries[j].thread, rob.entries[j].pc).opcode) && rob.entries[j].thread == reservation_stations.entries[i].thread && rob.entries[j].seq > rob.entries[store].seq && rob.entries[j].seq < rob.entries[reservation_stations.entries[i].destination].seq && (rob.entries[j].state == ISSUE || (rob.entries[j].state == EXECUTE && accesses_overlap(instruction_of(rob.entries[j].thread, rob.entries[j].pc).opcode, rob.entries[j].destination, LW, reservation_stations.entries[i].value1 + reservation_stations.entries[i].address))))
+						store = UNDEFINED;
+				if (store != UNDEFINED)
+				{
+					reservation_stations.entries[i].address = reservation_stations.entries[i].address + reservation_stations.entries[i].value1;
+					rob.entries[reservation_stations.entries[i].destination].state = EXECUTE;
+					reservation_stations.entries[i].value2 = rob.entries[store].value;
+					rob.entries[reservation_stations.entries[i].destination].store_bypassed = true;
+					pending_instructions.entries[reservation_stations.entries[i].destination].exe = clock_cycles;
+					if (reservation_stations.entries[i].fused_destination != UNDEFINED)
+						start_fused(i);
+				}
 			}
 		}
 	}
 
-	cout << "Past execution";
+	TRACE("Past execution");
 	//Write Results Stage
 	for (int i = 0; i < num_units; i++) //this loop looks for ready values
 	{
 		if (exec_units[i].pc != UNDEFINED && exec_units[i].busy == 0)
 		{
-			for (int j = 0; j < rob.num_entries; j++) //this loop searches for ROB entries corresponding to the PC instruction on the execution unit
+			for (unsigned j = 0; j < rob.num_entries; j++) //this loop searches for the ROB entry of the instruction on the execution unit
 			{
-				if (exec_units[i].pc == rob.entries[j].pc && rob.entries[j].pc != UNDEFINED && instr_memory[(exec_units[i].pc - instr_base_address) / 0x00000004].opcode != SWS)
+				if (j == exec_units[i].rob_entry && rob.entries[j].pc != UNDEFINED && !is_store(instruction_of(exec_units[i].thread, exec_units[i].pc).opcode))
 				{
-					rob.entries[j].value = exec_units[i].ALUoutput;
+					bool vector_result = is_vector(instruction_of(exec_units[i].thread, exec_units[i].pc).opcode);
+					write_result(j, exec_units[i].ALUoutput);
+					if (vector_result)
+						memcpy(rob.entries[j].vector_value, exec_units[i].vector_output, sizeof(exec_units[i].vector_output));
 					rob.entries[j].state = WRITE_RESULT;
 					pending_instructions.entries[j].wr = clock_cycles;
-					for (int x = 0; x < reservation_stations.num_entries; x++) //this loop updates the reservation station entries
-					{
-						if (reservation_stations.entries[x].tag1 == j) //replacing the tag with the value for value 1 in all reservation station entries
-						{
-							reservation_stations.entries[x].value1 = exec_units[i].ALUoutput;
-							reservation_stations.entries[x].tag1 = UNDEFINED;
-						}
-						if (reservation_stations.entries[x].tag2 == j) //replacing the tag with the value for value 2 in all reservation station entries
-						{
-							reservation_stations.entries[x].value2 = exec_units[i].ALUoutput;
-							reservation_stations.entries[x].tag2 = UNDEFINED;
-						}
-						if (reservation_stations.entries[x].pc == exec_units[i].pc) //this is to clear the instruction from the reservation station
-						{
-							res_station_entry_t *ptr = &reservation_stations.entries[x];
-							clean_res_station(ptr);
-						}
-					}
+					broadcast(j, exec_units[i].ALUoutput, vector_result ? exec_units[i].vector_output : NULL);
+					if (reservation_stations.entries[exec_units[i].res_station].fused_destination != UNDEFINED)
+						complete_fused(exec_units[i].res_station, exec_units[i].ALUoutput);
+					free_res_station(exec_units[i].res_station); //this is to clear the instruction from the reservation station
 					exec_units[i].ALUoutput = UNDEFINED;
 					exec_units[i].pc = UNDEFINED;
 					loadReleasedUnit = i;
@@ -1274,17 +3594,18 @@ ISSUE_STAGE:
 	{
 		if (rob.entries[i].pc != UNDEFINED)
 		{
-			if (instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode == SWS && rob.entries[i].state == EXECUTE && pending_instructions.entries[i].exe < clock_cycles)
+			if (is_store(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode) && rob.entries[i].state == EXECUTE && pending_instructions.entries[i].exe < clock_cycles)
 			{
 				for (int j = 0; j < reservation_stations.num_entries; j++)
 				{
-					if (reservation_stations.entries[j].pc == rob.entries[i].pc)
+					if (reservation_stations.entries[j].pc != UNDEFINED && reservation_stations.entries[j].destination == (unsigned)i)
 					{
 						rob.entries[i].value = reservation_stations.entries[j].value1;
+						memcpy(rob.entries[i].vector_value, reservation_stations.entries[j].vector1, sizeof(rob.entries[i].vector_value));
+						energy_events[EVENT_ROB_WRITE]++;
 						rob.entries[i].state = WRITE_RESULT;
 						pending_instructions.entries[i].wr = clock_cycles;
-						res_station_entry_t *ptr = &reservation_stations.entries[j];
-						clean_res_station(ptr);
+						free_res_station(j);
 					}
 				}
 			}
@@ -1295,133 +3616,170 @@ ISSUE_STAGE:
 	{
 		if (reservation_stations.entries[i].pc != UNDEFINED)
 		{
-			if ((instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode == LWS || instr_memory[(reservation_stations.entries[i].pc - instr_base_address) / 0x00000004].opcode == LW) && rob.entries[reservation_stations.entries[i].destination].store_bypassed == true && pending_instructions.entries[reservation_stations.entries[i].destination].exe < clock_cycles)
+			if ((instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode == LWS || instruction_of(reservation_stations.entries[i].thread, reservation_stations.entries[i].pc).opcode == LW) && rob.entries[reservation_stations.entries[i].destination].store_bypassed == true && pending_instructions.entries[reservation_stations.entries[i].destination].exe < clock_cycles)
 			{
-				rob.entries[reservation_stations.entries[i].destination].value = reservation_stations.entries[i].value2;
+				write_result(reservation_stations.entries[i].destination, reservation_stations.entries[i].value2);
 				pending_instructions.entries[reservation_stations.entries[i].destination].wr = clock_cycles;
 				rob.entries[reservation_stations.entries[i].destination].state = WRITE_RESULT;
-				for (int x = 0; x < reservation_stations.num_entries; x++) //this loop updates the reservation station entries
-				{
-					if (reservation_stations.entries[x].pc != UNDEFINED)
-					{
-						if (reservation_stations.entries[x].tag1 == reservation_stations.entries[i].destination) //replacing the tag with the value for value 1 in all reservation station entries
-						{
-							reservation_stations.entries[x].value1 = rob.entries[reservation_stations.entries[i].destination].value;
-							reservation_stations.entries[x].tag1 = UNDEFINED;
-						}
-						if (reservation_stations.entries[x].tag2 == reservation_stations.entries[i].destination) //replacing the tag with the value for value 2 in all reservation station entries
-						{
-							reservation_stations.entries[x].value2 = rob.entries[reservation_stations.entries[i].destination].value;
-							reservation_stations.entries[x].tag2 = UNDEFINED;
-						}
-					}
-				}
-				res_station_entry_t *ptr = &reservation_stations.entries[i];
-				clean_res_station(ptr);
+				broadcast(reservation_stations.entries[i].destination, result_of(reservation_stations.entries[i].destination), NULL);
+				if (reservation_stations.entries[i].fused_destination != UNDEFINED)
+					complete_fused(i, reservation_stations.entries[i].value2);
+				free_res_station(i);
 			}
 		}
 	}
 
+	if (store_buffer_size)
+		drain_store_buffer();
+
 	//Commit Stage
-	cout << "Entering Commit";
+	TRACE("Entering Commit");
+	if (select_policy == SELECT_CRITICAL_FIRST)
+		mark_critical();
 
 	for (int i = 0; i < rob.num_entries; i++)
 	{
 
 		bool dontCommit = false;
-		if (rob.entries[i].ready == true)
+		if (rob.entries[i].ready == true && !committed[rob.entries[i].thread])
 		{
-			// Checking if there are earlier instructions that we should wait for
+			hw_context_t *owner = &contexts[rob.entries[i].thread];
+			// Checking if there are earlier instructions of the same thread that we should wait for
 			for (int j = 0; j < rob.num_entries; j++)
 			{
-				if (rob.entries[j].pc < rob.entries[i].pc)
+				if (rob.entries[j].pc != UNDEFINED && rob.entries[j].seq < rob.entries[i].seq && rob.entries[j].thread == rob.entries[i].thread)
 				{
 					dontCommit = true;
 				}
 			}
 			if (dontCommit == false)
 			{
-				if (!is_branch(instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode) && instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode != SWS)
+				if (!is_branch(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode) && !is_store(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode))
 				{
-					if (is_fp_alu(instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode) || instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode == LWS)
+					if (rob.entries[i].destination >= 2 * NUM_GP_REGISTERS)
+					{
+						for (unsigned l = 0; l < VECTOR_LANES; l++)
+							set_vector_register(rob.entries[i].destination - 2 * NUM_GP_REGISTERS, l, unsigned2float(rob.entries[i].vector_value[l]), rob.entries[i].thread);
+						if (i == owner->V_tags[rob.entries[i].destination - 2 * NUM_GP_REGISTERS])
+						{
+							owner->V_tags[rob.entries[i].destination - 2 * NUM_GP_REGISTERS] = UNDEFINED;
+						}
+					}
+					else if (is_fp_alu(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode) || instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode == LWS)
 					{
-						set_fp_register(rob.entries[i].destination - NUM_GP_REGISTERS, unsigned2float(rob.entries[i].value));
-						if (i == FP_tags[rob.entries[i].destination - NUM_GP_REGISTERS]) //This is so that it doesn't delete other instruction's tags
+						set_fp_register(rob.entries[i].destination - NUM_GP_REGISTERS, unsigned2float(result_of(i)), rob.entries[i].thread);
+						if (i == owner->FP_tags[rob.entries[i].destination - NUM_GP_REGISTERS]) //This is so that it doesn't delete other instruction's tags
 						{
-							FP_tags[rob.entries[i].destination - NUM_GP_REGISTERS] = UNDEFINED;
+							owner->FP_tags[rob.entries[i].destination - NUM_GP_REGISTERS] = UNDEFINED;
 						}
 					}
 					else
 					{
-						set_int_register(rob.entries[i].destination, rob.entries[i].value);
-						if (i == INT_tags[rob.entries[i].destination])
+						set_int_register(rob.entries[i].destination, result_of(i), rob.entries[i].thread);
+						if (i == owner->INT_tags[rob.entries[i].destination])
 						{
-							INT_tags[rob.entries[i].destination] = UNDEFINED;
+							owner->INT_tags[rob.entries[i].destination] = UNDEFINED;
 						}
 					}
 
+					//the result is read from the ROB and written to the register file (in merged register file mode,
+					//only the retirement map changes)
+					energy_events[EVENT_ROB_READ]++;
+					if (rob.entries[i].phys_dest == UNDEFINED)
+						energy_events[EVENT_RF_WRITE]++;
+					retire_register(i);
 					rob.entries[i].state = COMMIT;
 					pending_instructions.entries[i].commit = clock_cycles;
+					train_criticality(i);
 					commit_to_log(pending_instructions.entries[i]);
 					instr_window_entry_t *ptr = &pending_instructions.entries[i];
 					clean_instr_window(ptr);
 					rob_entry_t *ptr1 = &rob.entries[i];
 					clean_rob(ptr1);
 					instructions_executed++;
-					goto AFTER_COMMIT;
+					owner->instructions_executed++;
+					owner->last_commit_cycle = clock_cycles;
+					committed[rob.entries[i].thread] = true;
+					continue;
 				}
-				if (is_branch(instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode))
+				if (is_branch(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode))
 				{ //branch commit section
-					if (rob.entries[i].value == rob.entries[i].pc + 4)
+					energy_events[EVENT_ROB_READ]++;
+					if (rob.entries[i].value == rob.entries[i].predicted_pc)
 					{
 						rob.entries[i].state = COMMIT;
 						pending_instructions.entries[i].commit = clock_cycles;
+						train_criticality(i);
 						commit_to_log(pending_instructions.entries[i]);
 						instr_window_entry_t *ptr = &pending_instructions.entries[i];
 						clean_instr_window(ptr);
 						rob_entry_t *ptr1 = &rob.entries[i];
 						clean_rob(ptr1);
 						instructions_executed++;
-						goto AFTER_COMMIT;
+						owner->instructions_executed++;
+						owner->last_commit_cycle = clock_cycles;
+						committed[rob.entries[i].thread] = true;
+						continue;
 					}
-					else if (rob.entries[i].value != rob.entries[i].pc + 4)
+					else if (rob.entries[i].value != rob.entries[i].predicted_pc)
 					{
-						PC = rob.entries[i].value;
-						willBranch = true;
+						unsigned thread = rob.entries[i].thread;
+						owner->PC = rob.entries[i].value;
+						owner->will_branch = true;
+						if (frontend_enabled)
+							redirect_fetch(thread, owner->PC, rob.entries[i].pc);
+						if (profiler_enabled)
+							profile_of(rob.entries[i].thread, rob.entries[i].pc).mispredictions++;
 						rob.entries[i].state = COMMIT;
 						pending_instructions.entries[i].commit = clock_cycles;
+						train_criticality(i);
 						commit_to_log(pending_instructions.entries[i]);
 						instr_window_entry_t *ptr = &pending_instructions.entries[i];
 						clean_instr_window(ptr);
 						rob_entry_t *ptr1 = &rob.entries[i];
 						clean_rob(ptr1);
-						//rob flushed
+						//rob flushed (only the instructions of the thread of the branch)
+						bool rob_empty = true;
 						for (int i = 0; i < rob.num_entries; i++)
 						{
-							rob_entry_t *ptr = &rob.entries[i];
-							clean_rob(ptr);
+							if (rob.entries[i].thread == thread)
+							{
+								release_register(i);
+								rob_entry_t *ptr = &rob.entries[i];
+								clean_rob(ptr);
+							}
+							else if (rob.entries[i].pc != UNDEFINED)
+								rob_empty = false;
 						}
 						//reservation_stations flushed
 						for (int i = 0; i < reservation_stations.num_entries; i++)
 						{
-							res_station_entry_t *ptr = &reservation_stations.entries[i];
-							clean_res_station(ptr);
+							if (reservation_stations.entries[i].thread == thread)
+							{
+								free_res_station(i);
+							}
 						}
 						//execution units flushed
 						for (int i = 0; i < num_units; i++)
 						{
-							cout << "It's inside the exec flush";
-							exec_units[i].ALUoutput = UNDEFINED;
-							exec_units[i].pc = UNDEFINED;
-							exec_units[i].busy = 0;
+							if (exec_units[i].thread == thread || exec_units[i].pc == UNDEFINED)
+							{
+								TRACE("It's inside the exec flush");
+								exec_units[i].ALUoutput = UNDEFINED;
+								exec_units[i].pc = UNDEFINED;
+								exec_units[i].busy = 0;
+							}
 						}
 						//Tags flushed
 						for (int i = 0; i < NUM_GP_REGISTERS; i++)
 						{
-							FP_tags[i] = UNDEFINED;
-							INT_tags[i] = UNDEFINED;
+							owner->FP_tags[i] = UNDEFINED;
+							owner->INT_tags[i] = UNDEFINED;
+							owner->V_tags[i] = UNDEFINED;
 						}
-						ROBentryIndex = 0;
+						owner->rob_next = owner->rob_start;
+						if (rob_empty)
+							rob_next = 0;
 
 						unsigned minimum = 0; //This is to enter the pending instruction logs in sorted PC order
 						int theIndex;
@@ -1431,7 +3789,7 @@ ISSUE_STAGE:
 							theIndex = UNDEFINED;
 							for (int x = 0; x < pending_instructions.num_entries; x++)
 							{
-								if (pending_instructions.entries[x].pc < minimum)
+								if (pending_instructions.entries[x].pc < minimum && pending_instructions.entries[x].thread == thread)
 								{
 									minimum = pending_instructions.entries[x].pc;
 									theIndex = x;
@@ -1439,32 +3797,82 @@ ISSUE_STAGE:
 							}
 							if (theIndex != UNDEFINED && minimum != UNDEFINED)
 							{
+								if (profiler_enabled)
+									profile_of(thread, minimum).flushed++;
 								commit_to_log(pending_instructions.entries[theIndex]);
 								instr_window_entry_t *ptr = &pending_instructions.entries[theIndex];
 								clean_instr_window(ptr);
 							}
 						}
 						instructions_executed++;
-						goto AFTER_COMMIT;
+						owner->instructions_executed++;
+						owner->last_commit_cycle = clock_cycles;
+						committed[thread] = true;
+						continue;
+					}
+				}
+				//post-commit store buffer: the store leaves the ROB without taking the memory unit
+				if (store_buffer_size && is_store(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode) && rob.entries[i].state == WRITE_RESULT)
+				{
+					unsigned thread = rob.entries[i].thread;
+					if (!buffer_store(rob.entries[i].destination, rob.entries[i].pc))
+					{
+						store_buffer_stats.full_cycles++;
+						continue;
 					}
+					if (instruction_of(thread, rob.entries[i].pc).opcode == SWV)
+					{
+						for (unsigned l = 0; l < VECTOR_LANES; l++)
+							store_word(rob.entries[i].destination + 4 * l, rob.entries[i].vector_value[l]);
+					}
+					else
+						store_word(rob.entries[i].destination, rob.entries[i].value);
+					energy_events[EVENT_ROB_READ]++;
+					rob.entries[i].state = COMMIT;
+					pending_instructions.entries[i].commit = clock_cycles;
+					train_criticality(i);
+					commit_to_log(pending_instructions.entries[i]);
+					clean_instr_window(&pending_instructions.entries[i]);
+					clean_rob(&rob.entries[i]);
+					instructions_executed++;
+					owner->instructions_executed++;
+					owner->last_commit_cycle = clock_cycles;
+					committed[thread] = true;
+					continue;
 				}
-				if (instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode == SWS && get_free_unit(instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode) != UNDEFINED && rob.entries[i].state == WRITE_RESULT)
+				if (is_store(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode) && get_free_unit(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode) != UNDEFINED && rob.entries[i].state == WRITE_RESULT)
 				{
-					if (loadReleasedUnit != get_free_unit(instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode))
+					if (loadReleasedUnit != get_free_unit(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode))
 					{
-						write_memory(rob.entries[i].destination, rob.entries[i].value);
+						if (instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode == SWV)
+						{
+							for (unsigned l = 0; l < VECTOR_LANES; l++)
+								store_word(rob.entries[i].destination + 4 * l, rob.entries[i].vector_value[l]);
+						}
+						else
+							store_word(rob.entries[i].destination, rob.entries[i].value);
 						rob.entries[i].state = COMMIT;
 						instructions_executed++;
+						owner->instructions_executed++;
+						owner->last_commit_cycle = clock_cycles;
 						pending_instructions.entries[i].commit = clock_cycles;
+						train_criticality(i);
 						commit_to_log(pending_instructions.entries[i]);
-						int storeExecUnit = get_free_unit(instr_memory[(rob.entries[i].pc - instr_base_address) / 0x00000004].opcode);
+						int storeExecUnit = get_free_unit(instruction_of(rob.entries[i].thread, rob.entries[i].pc).opcode);
 						exec_units[storeExecUnit].pc = rob.entries[i].pc;
+						exec_units[storeExecUnit].rob_entry = i;
+						exec_units[storeExecUnit].thread = rob.entries[i].thread;
 						exec_units[storeExecUnit].busy = exec_units[storeExecUnit].latency;
+						unit_operations[exec_units[storeExecUnit].type]++;
+						energy_events[EVENT_ROB_READ]++;
+						energy_events[EVENT_MEM_WRITE]++;
+						if (hierarchy != NULL)
+							exec_units[storeExecUnit].busy += hierarchy->access(core_id, rob.entries[i].destination, true, clock_cycles, rob.entries[i].pc);
 						/*for (int j = 0; j < reservation_stations.num_entries; j++)
 						{
 							if (reservation_stations.entries[j].pc != UNDEFINED)
 							{
-								if (instr_memory[(rob.entries[reservation_stations.entries[j].destination].pc - instr_base_address) / 0x00000004].opcode == LWS && rob.entries[reservation_stations.entries[j].destination].state == ISSUE && reservation_stations.entries[j].address + reservation_stations.entries[j].value1 == rob.entries[i].destination)
+								if (instruction_of(rob.entries[reservation_stations.entries[j].destination].thread, rob.entries[reservation_stations.entries[j].destination].pc).opcode == LWS && rob.entries[reservation_stations.entries[j].destination].state == ISSUE && reservation_stations.entries[j].address + reservation_stations.entries[j].value1 == rob.entries[i].destination)
 								{
 									/*reservation_stations.entries[j].address = reservation_stations.entries[j].address + reservation_stations.entries[j].value1;
 									rob.entries[reservation_stations.entries[j].destination].state = EXECUTE;
@@ -1480,8 +3888,6 @@ ISSUE_STAGE:
 		}
 	}
 
-AFTER_COMMIT:
-
 	for (int i = 0; i < rob.num_entries; i++)
 	{
 		if (pending_instructions.entries[i].wr != UNDEFINED)
@@ -1492,19 +3898,19 @@ AFTER_COMMIT:
 
 	decrement_units_busy_time();
 	//debug_units();
-	if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode != EOP && issue_struct_stall == false && willBranch == false)
+	if (instr_memory[(PC - instr_base_address) / 0x00000004].opcode != EOP && issue_struct_stall == false && ctx->will_branch == false)
 	{
-		PC += 0x00000004;
+		PC = next_issue_pc(PC);
 	}
 	for (int i = 0; i < num_units; i++)
 	{
 		if (exec_units[i].pc != UNDEFINED)
 		{
-			if (instr_memory[(exec_units[i].pc - instr_base_address) / 0x00000004].opcode == SWS && exec_units[i].busy == 0)
+			if (is_store(instruction_of(exec_units[i].thread, exec_units[i].pc).opcode) && exec_units[i].busy == 0)
 			{
-				for (int y = 0; y < rob.num_entries; y++)
+				for (unsigned y = 0; y < rob.num_entries; y++)
 				{
-					if (rob.entries[y].pc == exec_units[i].pc)
+					if (y == exec_units[i].rob_entry && rob.entries[y].pc != UNDEFINED)
 					{
 						exec_units[i].pc = UNDEFINED;
 						instr_window_entry_t *ptr = &pending_instructions.entries[y];
@@ -1518,30 +3924,143 @@ AFTER_COMMIT:
 			}
 		}
 	}
-	cout << dec << " \n The number of clock cycles are:" << static_cast<int>(clock_cycles) << "\n";
-	cout << dec << " \n The instructions executed are:" << static_cast<int>(instructions_executed) << "\n";
+	TRACE(dec << " \n The number of clock cycles are:" << static_cast<int>(clock_cycles) << "\n");
+	TRACE(dec << " \n The instructions executed are:" << static_cast<int>(instructions_executed) << "\n");
 	//print_pending_instructions();
 	//print_rob();
+	if (frontend_enabled)
+		fetch();
+	if (histograms_enabled)
+		sample_histograms();
+	if (profiler_enabled)
+		sample_profile();
 	clock_cycles++;
-	if (cycles == NULL)
+}
+
+bool sim_ooo::run_until(unsigned max_cycles)
+{
+	while (clock_cycles < max_cycles && !program_completed())
+		step_and_skip(max_cycles - clock_cycles - 1);
+	if (!program_completed())
+		return false;
+	if (profiler_enabled)
+		print_profile();
+	return true;
+}
+
+/* true when the ROB is empty and no instruction is left to issue */
+bool sim_ooo::program_completed()
+{
+	if (store_buffer_count > 0)
+		return false;
+	for (unsigned i = 0; i < rob.num_entries; i++)
 	{
-		int notEmptyEntries = 0;
-		for (int i = 0; i < rob.num_entries; i++)
-		{
-			if (rob.entries[i].pc != UNDEFINED)
-			{
-				notEmptyEntries++;
-			}
-		}
-		if (notEmptyEntries > 0 || instr_memory[(PC - instr_base_address) / 0x00000004].opcode != EOP)
-		{
-			if (clock_cycles == 600)
-			{
-				//return;
-			}
-			run();
-		}
+		if (rob.entries[i].pc != UNDEFINED)
+			return false;
+	}
+	for (unsigned t = 0; t < num_threads; t++)
+	{
+		if (instruction_of(t, contexts[t].PC).opcode != EOP)
+			return false;
+	}
+	return true;
+}
+
+/* runs "cycles" clock cycles, or the program to completion if cycles = 0 */
+void sim_ooo::run(unsigned cycles)
+{
+	if (cycles == 0)
+	{
+		do
+			step_and_skip(UNDEFINED);
+		while (!program_completed());
+		if (profiler_enabled)
+			print_profile();
+		return;
+	}
+	for (unsigned c = 0; c < cycles;)
+		c += step_and_skip(cycles - c - 1);
+}
+
+/* number of execution units holding an instruction */
+unsigned sim_ooo::units_in_use()
+{
+	unsigned count = 0;
+	for (unsigned u = 0; u < num_units; u++)
+		if (exec_units[u].pc != UNDEFINED)
+			count++;
+	return count;
+}
+
+/* A clock cycle is idle if no instruction issued, started executing, wrote its result, committed or left a unit:
+   then the only state that changed are the execution unit timers, which step() only compares with 0, and the
+   conditions on clock_cycles, which are all monotonic (stamp < clock_cycles). So every following cycle is idle as
+   well until the first timer expires, and those cycles only need the per-cycle bookkeeping of step(). */
+unsigned sim_ooo::step_and_skip(unsigned max_skip)
+{
+	unsigned long long sequence = issue_sequence;
+	unsigned executed = instructions_executed;
+	unsigned units = units_in_use();
+	unsigned long long prf_stalls[NUM_PRF_TYPES];
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+		prf_stalls[k] = prf_stall_cycles[k];
+
+	step();
+
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+		prf_stalls[k] = prf_stall_cycles[k] - prf_stalls[k];
+
+	//SMT contexts rotate, the front-end fetches and the store buffer drains in idle cycles too
+	if (!skipping_enabled || max_skip == 0 || num_threads > 1 || frontend_enabled || store_buffer_count > 0)
+		return 1;
+	if (issue_sequence != sequence || instructions_executed != executed || units_in_use() != units)
+		return 1;
+	unsigned cycle = clock_cycles - 1;
+	for (unsigned i = 0; i < pending_instructions.num_entries; i++)
+	{
+		instr_window_entry_t *entry = &pending_instructions.entries[i];
+		if (entry->issue == cycle || entry->exe == cycle || entry->wr == cycle || entry->commit == cycle)
+			return 1;
+	}
+
+	//next event: the first timer to expire (its cycle is simulated normally); a unit whose timer already expired
+	//writes back in the next cycle
+	unsigned next_event = UNDEFINED;
+	for (unsigned u = 0; u < num_units; u++)
+	{
+		if (exec_units[u].pc != UNDEFINED && exec_units[u].busy == 0)
+			return 1;
+		if (exec_units[u].busy > 0 && exec_units[u].busy < next_event)
+			next_event = exec_units[u].busy;
+	}
+	if (next_event == UNDEFINED || next_event == 1)
+		return 1;
+	unsigned skip = min(next_event - 1, max_skip);
+	for (unsigned c = 0; c < skip; c++)
+	{
+		if (select_policy == SELECT_RANDOM)
+			schedule();
+		for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
+			prf_stall_cycles[k] += prf_stalls[k];
+		decrement_units_busy_time();
+		if (histograms_enabled)
+			sample_histograms();
+		if (profiler_enabled)
+			sample_profile();
+		clock_cycles++;
 	}
+	skipped_cycles += skip;
+	return 1 + skip;
+}
+
+void sim_ooo::enable_idle_skipping(bool enable)
+{
+	skipping_enabled = enable;
+}
+
+unsigned long long sim_ooo::get_skipped_cycles()
+{
+	return skipped_cycles;
 }
 
 //reset the state of the simulator - please complete
@@ -1552,28 +4071,103 @@ void sim_ooo::reset()
 	init_log();
 
 	// data memory
-	for (unsigned i = 0; i < data_memory_size; i++)
-		data_memory[i] = 0xFF;
+	memset(data_memory, 0xFF, data_memory_size);
 
-	//instr memory
-	for (int i = 0; i < PROGRAM_SIZE; i++)
+	for (unsigned t = 0; t < num_threads; t++)
 	{
-		instr_memory[i].opcode = (opcode_t)EOP;
-		instr_memory[i].src1 = UNDEFINED;
-		instr_memory[i].src2 = UNDEFINED;
-		instr_memory[i].dest = UNDEFINED;
-		instr_memory[i].immediate = UNDEFINED;
+		hw_context_t *ctx = &contexts[t];
+
+		//instr memory
+		for (int i = 0; i < PROGRAM_SIZE; i++)
+		{
+			ctx->instr_memory[i].opcode = (opcode_t)EOP;
+			ctx->instr_memory[i].src1 = UNDEFINED;
+			ctx->instr_memory[i].src2 = UNDEFINED;
+			ctx->instr_memory[i].src3 = UNDEFINED;
+			ctx->instr_memory[i].dest = UNDEFINED;
+			ctx->instr_memory[i].immediate = UNDEFINED;
+			ctx->source_lines[i].clear();
+		}
+		ctx->num_instructions = 0;
+		ctx->instr_base_address = 0;
+		ctx->PC = 0;
+
+		//general purpose registers
+		for (int i = 0; i < NUM_GP_REGISTERS; i++)
+		{
+			ctx->FP_regs[i] = UNDEFINED;
+			ctx->INT_regs[i] = UNDEFINED;
+			ctx->INT_tags[i] = UNDEFINED;
+			ctx->FP_tags[i] = UNDEFINED;
+			ctx->V_tags[i] = UNDEFINED;
+			for (unsigned l = 0; l < VECTOR_LANES; l++)
+				ctx->V_regs[i][l] = UNDEFINED;
+		}
+
+		//ROB partition (the whole ROB if it is shared)
+		ctx->rob_start = partitioned_rob ? t * rob.num_entries / num_threads : 0;
+		ctx->rob_end = partitioned_rob ? (t + 1) * rob.num_entries / num_threads : rob.num_entries;
+		ctx->rob_next = ctx->rob_start;
+		ctx->will_branch = false;
+		ctx->instructions_executed = 0;
+		ctx->last_commit_cycle = 0;
+
+		//fetch queue
+		ctx->fetch_head = 0;
+		ctx->fetch_count = 0;
+		ctx->fetch_pc = UNDEFINED;
+		ctx->fetch_stall_until = 0;
+		ctx->loop_start = UNDEFINED;
+		ctx->loop_end = UNDEFINED;
+		ctx->loop_candidate = UNDEFINED;
+		ctx->loop_iterations = 0;
+
+		//profile and criticality predictor
+		memset(ctx->profile, 0, sizeof(ctx->profile));
+		memset(ctx->criticality, 0, sizeof(ctx->criticality));
 	}
+	rob_next = 0;
+	issue_thread = num_threads - 1;
+	issue_sequence = 0;
+	select_seed = 1;
 
-	//general purpose registers
-	for (int i = 0; i < NUM_GP_REGISTERS; i++)
+	//instruction cache
+	for (unsigned i = 0; i < icache_sets * icache_assoc; i++)
+		icache_tags[i] = UNDEFINED;
+	icache_use_counter = 0;
+	memset(&frontend_stats, 0, sizeof(frontend_stats));
+
+	//store buffer
+	store_buffer_head = 0;
+	store_buffer_count = 0;
+	memset(&store_buffer_stats, 0, sizeof(store_buffer_stats));
+
+	//physical register files: register r of thread t is initially mapped to physical register t * NUM_GP_REGISTERS + r
+	for (unsigned k = 0; k < NUM_PRF_TYPES; k++)
 	{
-		FP_regs[i] = UNDEFINED;
-		INT_regs[i] = UNDEFINED;
-		INT_tags[i] = UNDEFINED;
-		FP_tags[i] = UNDEFINED;
+		prf_allocations[k] = 0;
+		prf_stall_cycles[k] = 0;
+		if (!prf_enabled)
+			continue;
+		for (unsigned t = 0; t < num_threads; t++)
+		{
+			for (unsigned r = 0; r < NUM_GP_REGISTERS; r++)
+			{
+				if (k == INT_PRF)
+					contexts[t].INT_retire_map[r] = t * NUM_GP_REGISTERS + r;
+				else
+					contexts[t].FP_retire_map[r] = t * NUM_GP_REGISTERS + r;
+			}
+		}
+		for (unsigned p = 0; p < prf_size[k]; p++)
+		{
+			prf_values[k][p] = UNDEFINED;
+			free_list[k][p] = (num_threads * NUM_GP_REGISTERS + p) % prf_size[k];
+		}
+		free_head[k] = 0;
+		free_count[k] = prf_size[k] - num_threads * NUM_GP_REGISTERS;
+		min_free_count[k] = free_count[k];
 	}
-	ROBentryIndex = 0;
 
 	//rob
 	for (int i = 0; i < rob.num_entries; i++)
@@ -1581,11 +4175,14 @@ void sim_ooo::reset()
 		rob_entry_t *ptr = &rob.entries[i];
 		clean_rob(ptr);
 	}
-	//reservation_stations
+	//reservation_stations (the padding of the tag arrays never matches a ROB entry)
+	for (unsigned k = 0; k < NUM_RS_OPERANDS; k++)
+		for (unsigned i = 0; i < rs_slots; i++)
+			rs_tags[k][i] = NO_TAG;
+	memset(rs_valid, 0, rs_slots / 64 * sizeof(unsigned long long));
 	for (int i = 0; i < reservation_stations.num_entries; i++)
 	{
-		res_station_entry_t *ptr = &reservation_stations.entries[i];
-		clean_res_station(ptr);
+		free_res_station(i);
 	}
 	//pending_instructions
 	for (int i = 0; i < pending_instructions.num_entries; i++)
@@ -1597,8 +4194,26 @@ void sim_ooo::reset()
 	//execution statistics
 	clock_cycles = 0;
 	instructions_executed = 0;
+	skipped_cycles = 0;
+	eliminated_zero_idioms = 0;
+	eliminated_moves = 0;
+	fused_branch_pairs = 0;
+	fused_load_pairs = 0;
 	issue_struct_stall = false;
-	vacantPlace = false;
+	memset(energy_events, 0, sizeof(energy_events));
+	memset(unit_operations, 0, sizeof(unit_operations));
+
+	//histograms
+	rob_occupancy.clear();
+	for (unsigned t = 0; t < NUM_RS_TYPES; t++)
+		rs_occupancy[t].clear();
+	for (unsigned t = 0; t < NUM_UNIT_TYPES; t++)
+		unit_occupancy[t].clear();
+	for (unsigned o = 0; o < NUM_OPCODES; o++)
+	{
+		issue_to_exe_latency[o].clear();
+		exe_to_commit_latency[o].clear();
+	}
 
 	//other required initializations
 }
@@ -1623,32 +4238,47 @@ void sim_ooo::debug_units()
 
 /* registers related */
 
-int sim_ooo::get_int_register(unsigned reg)
+int sim_ooo::get_int_register(unsigned reg, unsigned thread)
+{
+	return contexts[thread].INT_regs[reg];
+}
+
+void sim_ooo::set_int_register(unsigned reg, int value, unsigned thread)
+{
+	contexts[thread].INT_regs[reg] = value;
+}
+
+float sim_ooo::get_fp_register(unsigned reg, unsigned thread)
+{
+	return contexts[thread].FP_regs[reg];
+}
+
+void sim_ooo::set_fp_register(unsigned reg, float value, unsigned thread)
 {
-	return INT_regs[reg]; //please modify
+	contexts[thread].FP_regs[reg] = value;
 }
 
-void sim_ooo::set_int_register(unsigned reg, int value)
+unsigned sim_ooo::get_int_register_tag(unsigned reg, unsigned thread)
 {
-	INT_regs[reg] = value;
+	return contexts[thread].INT_tags[reg];
 }
 
-float sim_ooo::get_fp_register(unsigned reg)
+unsigned sim_ooo::get_fp_register_tag(unsigned reg, unsigned thread)
 {
-	return FP_regs[reg]; //please modify
+	return contexts[thread].FP_tags[reg];
 }
 
-void sim_ooo::set_fp_register(unsigned reg, float value)
+float sim_ooo::get_vector_register(unsigned reg, unsigned lane, unsigned thread)
 {
-	FP_regs[reg] = value;
+	return contexts[thread].V_regs[reg][lane];
 }
 
-unsigned sim_ooo::get_int_register_tag(unsigned reg)
+void sim_ooo::set_vector_register(unsigned reg, unsigned lane, float value, unsigned thread)
 {
-	return INT_tags[reg]; //please modify
+	contexts[thread].V_regs[reg][lane] = value;
 }
 
-unsigned sim_ooo::get_fp_register_tag(unsigned reg)
+unsigned sim_ooo::get_vector_register_tag(unsigned reg, unsigned thread)
 {
-	return FP_tags[reg]; //please modify
+	return contexts[thread].V_tags[reg];
 }
@@ -6,15 +6,30 @@
 #include <string>
 #include <cstring>
 #include <sstream>
+#include <map>
 
 using namespace std;
 
 #define UNDEFINED 0xFFFFFFFF //constant used for initialization
 #define NUM_GP_REGISTERS 32
-#define NUM_OPCODES 24
+#define NUM_OPCODES 30
 #define NUM_STAGES 4
 #define MAX_UNITS 10
-#define PROGRAM_SIZE 50
+#define PROGRAM_SIZE 1024
+#define NUM_RS_TYPES 5
+#define NUM_UNIT_TYPES 7
+#define NUM_STALL_CAUSES 7
+#define MAX_THREADS 8
+#define NUM_PRF_TYPES 2
+#define NUM_SELECT_POLICIES 4
+#define MAX_CRITICALITY 7
+#define MAX_FETCH_QUEUE 64
+#define LOOP_DETECT_ITERATIONS 2 //consecutive taken instances of a short backward branch that capture its loop in the loop buffer
+#define VECTOR_LANES 4 //single precision lanes of a vector register
+#define NUM_RS_OPERANDS 3 //source operands of a reservation station (Qj, Qk and the FMAS addend)
+#define NO_TAG 0xFFFF //operand tag of a reservation station that is not waiting for a result
+#define NUM_ENERGY_EVENTS 8
+#define NUM_LEAKAGE_STRUCTURES 4
 
 // instructions supported
 typedef enum
@@ -42,7 +57,13 @@ typedef enum
 	ADDS,
 	SUBS,
 	MULTS,
-	DIVS
+	DIVS,
+	LWV,
+	SWV,
+	ADDV,
+	SUBV,
+	MULV,
+	FMAS
 } opcode_t;
 
 // reservation stations types
@@ -51,7 +72,8 @@ typedef enum
 	INTEGER_RS,
 	ADD_RS,
 	MULT_RS,
-	LOAD_B
+	LOAD_B,
+	VECTOR_RS
 } res_station_t;
 
 // execution units types
@@ -61,7 +83,9 @@ typedef enum
 	ADDER,
 	MULTIPLIER,
 	DIVIDER,
-	MEMORY
+	MEMORY,
+	VECTOR,
+	FMA
 } exe_unit_t;
 
 // stages names
@@ -73,15 +97,83 @@ typedef enum
 	COMMIT
 } stage_t;
 
+// causes of stall cycles tracked by the profiler
+typedef enum
+{
+	STALL_ROB_FULL, // issue blocked because the ROB is full
+	STALL_RS_FULL,	// issue blocked because no reservation station of the required type is free
+	STALL_OPERANDS, // waiting in a reservation station for its source operands
+	STALL_UNIT,		// operands ready, but no execution unit available
+	STALL_MEMORY,	// load waiting for an older store to the same address
+	STALL_PRF_FULL,	// issue blocked because no physical register is free (merged register file mode)
+	STALL_FETCH		// instruction not fetched and decoded yet (decoupled front-end)
+} stall_cause_t;
+
+// policies used to select the ready instructions that start executing when they compete for the execution units
+typedef enum
+{
+	SELECT_POSITION,	  // reservation station order
+	SELECT_OLDEST_FIRST,  // lowest issue sequence number first
+	SELECT_RANDOM,		  // random order
+	SELECT_CRITICAL_FIRST // highest predicted criticality first, then oldest first
+} select_policy_t;
+
+// physical register files (merged register file mode)
+typedef enum
+{
+	INT_PRF, // integer physical registers
+	FP_PRF	 // floating point physical registers
+} prf_type_t;
+
+// policies used to select the hardware thread that issues in each clock cycle
+typedef enum
+{
+	FETCH_ROUND_ROBIN, // threads take turns
+	FETCH_ICOUNT	   // thread with the fewest instructions waiting to execute
+} fetch_policy_t;
+
+// micro-architectural events counted by the energy model (the operations of the execution units are counted per unit type)
+typedef enum
+{
+	EVENT_RS_WRITE,		 // reservation station written at issue, or operand captured from the CDB
+	EVENT_CDB_BROADCAST, // result broadcast on the CDB
+	EVENT_ROB_READ,		 // ROB entry read (operand at issue, instruction at commit)
+	EVENT_ROB_WRITE,	 // ROB entry written (allocation at issue, result)
+	EVENT_RF_READ,		 // register read (operand at issue)
+	EVENT_RF_WRITE,		 // register written (at commit, or result in merged register file mode)
+	EVENT_MEM_READ,		 // data memory read by a load (forwarded loads excluded)
+	EVENT_MEM_WRITE		 // data memory written by a store
+} energy_event_t;
+
+// structures whose leakage grows with their size
+typedef enum
+{
+	LEAK_ROB,		// per ROB entry
+	LEAK_RS,		// per reservation station
+	LEAK_REGISTERS, // per integer or floating point register (physical registers in merged register file mode)
+	LEAK_UNITS		// per execution unit
+} leakage_structure_t;
+
+// energy estimate of a run (see sim_ooo::get_energy)
+typedef struct
+{
+	double dynamic; // energy of the events (pJ)
+	double leakage; // leakage energy (pJ)
+	double total;	// dynamic + leakage (pJ)
+	double power;	// average power (mW)
+} energy_t;
+
 // instruction data type
 typedef struct
 {
 	opcode_t opcode;	//opcode
 	unsigned src1;		//first source register in the assembly instruction (for SW, register to be written to memory)
 	unsigned src2;		//second source register in the assembly instruction
+	unsigned src3;		//third source register in the assembly instruction (FMAS addend)
 	unsigned dest;		//destination register
 	unsigned immediate; //immediate field
 	string label;		//for conditional branches, label of the target instruction - used only for parsing/debugging purposes
+	bool fuse_next;		//decoded as the first instruction of a macro-op fusion pair with the next one
 } instruction_t;
 
 // execution unit
@@ -94,13 +186,18 @@ typedef struct
 					  // to the latency of the unit when the unit becomes busy, and decremented
 					  // at each clock cycle
 	unsigned pc;	  // PC of the instruction using the functional unit
+	unsigned thread;  // hardware thread of the instruction using the functional unit
 	unsigned ALUoutput;
+	unsigned vector_output[VECTOR_LANES]; // lanes of the result of a vector instruction (ALUoutput is then 0)
+	unsigned res_station; // reservation station of the instruction using the functional unit (not used by stores)
+	unsigned rob_entry;	  // ROB entry of the instruction using the functional unit
 } unit_t;
 
 // entry in the "instruction window"
 typedef struct
 {
 	unsigned pc;	 // PC of the instruction
+	unsigned thread; // hardware thread of the instruction
 	unsigned issue;	 // clock cycle when the instruction is issued
 	unsigned exe;	 // clock cycle when the instruction enters execution
 	unsigned wr;	 // clock cycle when the instruction enters write result
@@ -112,26 +209,136 @@ typedef struct
 {
 	bool ready;			  // ready field
 	unsigned pc;		  // pc of corresponding instruction (set to UNDEFINED if ROB entry is available)
+	unsigned thread;	  // hardware thread of corresponding instruction
 	stage_t state;		  // state field
-	unsigned destination; // destination field
-	unsigned value;		  // value field
+	unsigned destination; // destination field (floating point registers are offset by NUM_GP_REGISTERS, vector registers by 2 * NUM_GP_REGISTERS)
+	unsigned value;		  // value field (not used for register results in merged register file mode; 0 once a vector result is ready)
+	unsigned vector_value[VECTOR_LANES]; // lanes of a vector result, or of the vector written by a vector store
 	bool store_bypassed;  //I added this field
+	unsigned phys_dest;	  // physical register written by the instruction (merged register file mode, UNDEFINED if none)
+	unsigned long long seq; // issue sequence number
+	bool blocked_commit;  // the instruction was the oldest of its thread before completing (criticality training)
+	unsigned predicted_pc; // PC issued after the instruction: a branch whose target differs is mispredicted
 } rob_entry_t;
 
+// histogram: bucket value -> number of samples
+typedef map<unsigned, unsigned long long> histogram_t;
+
+// per static instruction profile
+typedef struct
+{
+	unsigned long long executed;				  // number of times the instruction committed
+	unsigned long long cycles[NUM_STAGES];		  // clock cycles spent in each stage (including squashed instances)
+	unsigned long long stalls[NUM_STALL_CAUSES]; // stall cycles by cause
+	unsigned long long mispredictions;			  // number of mispredicted instances (branches only)
+	unsigned long long flushed;					  // number of instances squashed by a misprediction
+} pc_profile_t;
+
+// dataflow limit of a program (see get_dataflow_limit)
+typedef struct
+{
+	unsigned long long instructions;		  // dynamic instructions (EOP excluded)
+	unsigned long long critical_path;		  // critical path length with all latencies equal to 1
+	unsigned long long critical_path_latency; // critical path length with the latencies of the execution units
+} dataflow_limit_t;
+
+// fetch queue entry (decoupled front-end)
+typedef struct
+{
+	unsigned pc;		   // PC of the fetched instruction
+	unsigned ready_cycle; // first clock cycle in which the instruction can issue (after decode)
+	unsigned next_pc;	   // PC fetched after the instruction (the loop start after the branch closing a captured loop)
+} fetch_entry_t;
+
+// statistics of the decoupled front-end
+typedef struct
+{
+	unsigned long long fetched;			   // instructions fetched
+	unsigned long long squashed;		   // fetched instructions discarded by mispredictions
+	unsigned long long icache_accesses;	   // instruction cache accesses (one per fetch block)
+	unsigned long long icache_misses;	   // instruction cache misses
+	unsigned long long icache_stall_cycles; // clock cycles in which fetch waited for an instruction cache miss
+	unsigned long long queue_full_cycles;  // clock cycles in which fetch was blocked by a full fetch queue
+	unsigned long long starved_cycles;	   // clock cycles in which issue found no decoded instruction
+	unsigned long long loop_captures;	   // loops captured by the loop buffer
+	unsigned long long loop_delivered;	   // instructions delivered by the loop buffer (included in fetched)
+} frontend_stats_t;
+
+// entry of the post-commit store buffer
+typedef struct
+{
+	unsigned line;		 // line written by the entry (address / line size of the buffer)
+	unsigned pc;		 // first store written into the entry
+	unsigned drain_done; // clock cycle in which the entry is written to memory (UNDEFINED: not draining yet)
+} store_buffer_entry_t;
+
+// statistics of the post-commit store buffer
+typedef struct
+{
+	unsigned long long stores;		// stores committed into the buffer
+	unsigned long long combined;	// stores combined into an entry already holding their line
+	unsigned long long drains;		// entries written to memory
+	unsigned long long full_cycles; // clock cycles in which the oldest store could not commit because the buffer was full
+	unsigned max_occupancy;			// largest number of entries in use
+} store_buffer_stats_t;
+
+// hardware thread context: program, architectural registers and rename tables of one thread
+typedef struct
+{
+	instruction_t instr_memory[PROGRAM_SIZE]; // instruction memory
+	unsigned instr_base_address;			  // base address in the instruction memory where the program is loaded
+	string source_lines[PROGRAM_SIZE];		  // source code of the program (used by the profiler listing)
+	unsigned num_instructions;				  // number of instructions in the program
+	pc_profile_t profile[PROGRAM_SIZE];		  // per-PC profile
+	unsigned char criticality[PROGRAM_SIZE];  // per-PC saturating criticality counters (0..MAX_CRITICALITY)
+	unsigned PC;							  // program counter
+	int INT_regs[NUM_GP_REGISTERS];			  // integer registers
+	float FP_regs[NUM_GP_REGISTERS];		  // floating point registers
+	int INT_tags[NUM_GP_REGISTERS];			  // ROB entry that will write each integer register (UNDEFINED if none)
+	int FP_tags[NUM_GP_REGISTERS];			  // ROB entry that will write each floating point register (UNDEFINED if none)
+	float V_regs[NUM_GP_REGISTERS][VECTOR_LANES]; // vector registers (packed single precision)
+	int V_tags[NUM_GP_REGISTERS];			  // ROB entry that will write each vector register (UNDEFINED if none)
+	unsigned INT_retire_map[NUM_GP_REGISTERS]; // physical register holding the committed value of each integer register (merged register file mode)
+	unsigned FP_retire_map[NUM_GP_REGISTERS];  // physical register holding the committed value of each floating point register (merged register file mode)
+	unsigned rob_start;						  // first ROB entry the thread can allocate
+	unsigned rob_end;						  // last ROB entry the thread can allocate + 1
+	unsigned rob_next;						  // next ROB entry to allocate (partitioned ROB only)
+	bool will_branch;						  // set when a mispredicted branch redirects the PC in the current clock cycle
+	unsigned instructions_executed;			  // instructions committed by the thread
+	unsigned last_commit_cycle;				  // clock cycle of the last commit of the thread
+	fetch_entry_t fetch_queue[MAX_FETCH_QUEUE]; // fetched instructions waiting to issue (decoupled front-end)
+	unsigned fetch_head;					  // oldest entry of the fetch queue
+	unsigned fetch_count;					  // number of entries in the fetch queue
+	unsigned fetch_pc;						  // next PC to fetch (UNDEFINED: start from PC)
+	unsigned fetch_stall_until;				  // clock cycle in which the pending instruction cache miss is served
+	unsigned loop_start;					  // first instruction of the loop held by the loop buffer (UNDEFINED if none)
+	unsigned loop_end;						  // backward branch closing the loop held by the loop buffer
+	unsigned loop_candidate;				  // last short backward branch taken (loop detection)
+	unsigned loop_iterations;				  // consecutive taken instances of loop_candidate
+	unsigned issue_next_pc;					  // next_pc of the last instruction issued from the fetch queue
+} hw_context_t;
+
 // reservation station entry
 typedef struct
 {
 	res_station_t type;	  // reservation station type
 	unsigned name;		  // reservation station name (i.e., "Int", "Add", "Mult", "Load") for logging purposes
 	unsigned pc;		  // pc of corresponding instruction (set to UNDEFINED if reservation station is available)
+	unsigned thread;	  // hardware thread of corresponding instruction
 	unsigned value1;	  // Vj field
 	unsigned value2;	  // Vk field
-	unsigned tag1;		  // Qj field
-	unsigned tag2;		  // Qk field
+	unsigned value3;	  // third operand (FMAS addend)
 	unsigned destination; // destination field
 	unsigned address;	  // address field (for loads and stores)
+	unsigned vector1[VECTOR_LANES]; // lanes of a vector Vj (value1 is then 0)
+	unsigned vector2[VECTOR_LANES]; // lanes of a vector Vk (value2 is then 0)
+	unsigned fused_destination; // ROB entry of the other instruction of a fused pair (UNDEFINED if not fused)
 } res_station_entry_t;
 
+// ROB entry an operand of a reservation station is waiting for (Qj, Qk and the FMAS addend are kept in separate
+// arrays of the simulator, see sim_ooo::rs_tags)
+typedef unsigned short rs_tag_t;
+
 //instruction window
 typedef struct
 {
@@ -153,11 +360,259 @@ typedef struct
 	res_station_entry_t *entries;
 } res_stations_t;
 
+// bit-level conversions between single precision values and the words stored in registers and memory
+unsigned float2unsigned(float value);
+float unsigned2float(unsigned value);
+
+// memory hierarchy below the core (e.g., coherent private caches), used to model the timing of the data memory accesses
+class memory_hierarchy
+{
+public:
+	virtual ~memory_hierarchy() {}
+
+	// returns the clock cycles added to the latency of the memory unit by an access of "core" to "address" in clock cycle "cycle";
+	// "pc" is the address of the load or store instruction
+	virtual unsigned access(unsigned core, unsigned address, bool write, unsigned cycle, unsigned pc) = 0;
+
+	// functional accesses of the loads and stores of "core" to the word at "address": a hierarchy can serve them
+	// itself by returning true; otherwise (the default) the core reads and writes its data memory
+	virtual bool load(unsigned core, unsigned address, unsigned *value) { return false; }
+	virtual bool store(unsigned core, unsigned address, unsigned value, unsigned cycle) { return false; }
+};
+
 class sim_ooo
 {
 
 	/* Add the data members required by your simulator's implementation here */
 
+	//occupancy and latency histograms (disabled by default)
+	bool histograms_enabled;
+	histogram_t rob_occupancy;
+	histogram_t rs_occupancy[NUM_RS_TYPES];
+	histogram_t unit_occupancy[NUM_UNIT_TYPES];
+	histogram_t issue_to_exe_latency[NUM_OPCODES];
+	histogram_t exe_to_commit_latency[NUM_OPCODES];
+
+	//samples the occupancy of the ROB, reservation stations and execution units
+	void sample_histograms();
+
+	//records the latencies of an instruction leaving the instruction window
+	void record_latencies(instr_window_entry_t iwe);
+
+	//per-PC hotspot profiler (disabled by default); the profile itself is kept in the thread contexts
+	bool profiler_enabled;
+
+	//accumulates the per-PC stage and stall cycles of the current clock cycle
+	void sample_profile();
+
+	//simulates one clock cycle
+	void step();
+
+	//idle cycle skipping (enabled by default): after an idle clock cycle, run() advances to the next event directly
+	bool skipping_enabled;
+	unsigned long long skipped_cycles;
+
+	//simulates one clock cycle, and if it was idle up to "max_skip" following idle cycles; returns the cycles simulated
+	unsigned step_and_skip(unsigned max_skip);
+
+	//returns the number of execution units holding an instruction
+	unsigned units_in_use();
+
+	//move elimination (disabled by default)
+	bool elimination_enabled;
+	unsigned long long eliminated_zero_idioms;
+	unsigned long long eliminated_moves; // register moves and immediate loads
+
+	//true if the instruction at "pc" of the issuing thread can be resolved at rename: its result is returned in
+	//"value", and "zero" tells a zero idiom
+	bool eliminate(unsigned pc, unsigned *value, bool *zero);
+
+	//macro-op fusion (disabled by default)
+	bool fusion_enabled;
+	unsigned long long fused_branch_pairs;
+	unsigned long long fused_load_pairs;
+
+	//true if the pair starting at "pc" of the issuing thread finds its two ROB entries, physical registers and
+	//fetched instructions
+	bool can_fuse(unsigned pc);
+
+	//issues the pair starting at "pc" of the issuing thread as one micro-op; returns false if no reservation
+	//station is free
+	bool issue_fused_pair(unsigned pc);
+
+	//the other instruction of the micro-op in reservation station "res_station" starts executing / writes its
+	//result ("value" is the result of the micro-op)
+	void start_fused(unsigned res_station);
+	void complete_fused(unsigned res_station, unsigned value);
+
+	//energy model: event counts, energy of each event and of each operation of a unit type (pJ), leakage of each
+	//structure per entry and clock cycle (pJ), clock frequency (GHz)
+	unsigned long long energy_events[NUM_ENERGY_EVENTS];
+	unsigned long long unit_operations[NUM_UNIT_TYPES];
+	double event_energy[NUM_ENERGY_EVENTS];
+	double unit_energy[NUM_UNIT_TYPES];
+	double leakage_energy[NUM_LEAKAGE_STRUCTURES];
+	double clock_ghz;
+
+	//restores the default energy table
+	void init_energy_table();
+
+	//counts the events of the issue of the instruction at "pc" of the issuing thread: the ROB entry and the
+	//reservation station (if "res_station") written, and the reads of the source operands that are available
+	void count_issue_events(unsigned pc, bool res_station);
+
+	//hardware thread contexts sharing the reservation stations, the execution units and the ROB
+	hw_context_t *contexts;
+	unsigned num_threads;
+	fetch_policy_t fetch_policy;
+	bool partitioned_rob;
+
+	//next ROB entry to allocate (shared ROB)
+	unsigned rob_next;
+
+	//thread issuing in the current clock cycle
+	unsigned issue_thread;
+
+	//selects the thread that issues in the current clock cycle according to the fetch policy
+	unsigned select_thread();
+
+	//true when "thread" has no instructions left to issue and none in the ROB
+	bool thread_completed(unsigned thread);
+
+	//returns the instruction at address "pc" in the program of "thread"
+	instruction_t &instruction_of(unsigned thread, unsigned pc);
+
+	//returns the profile of the instruction at address "pc" in the program of "thread"
+	pc_profile_t &profile_of(unsigned thread, unsigned pc);
+
+	//merged register file mode (disabled by default: the results are kept in the ROB until they commit);
+	//the rename map is the tag table of each thread composed with the physical destination of the ROB entries
+	bool prf_enabled;
+	unsigned prf_size[NUM_PRF_TYPES];
+	unsigned *prf_values[NUM_PRF_TYPES];		// UNDEFINED until the producer writes its result
+	unsigned *free_list[NUM_PRF_TYPES];			// circular queue of free physical registers
+	unsigned free_head[NUM_PRF_TYPES];
+	unsigned free_count[NUM_PRF_TYPES];
+	unsigned min_free_count[NUM_PRF_TYPES];
+	unsigned long long prf_allocations[NUM_PRF_TYPES];
+	unsigned long long prf_stall_cycles[NUM_PRF_TYPES];
+
+	//returns the result of the instruction in ROB entry "rob_index" (UNDEFINED if not available yet)
+	unsigned result_of(unsigned rob_index);
+
+	//stores the result of the instruction in ROB entry "rob_index"
+	void write_result(unsigned rob_index, unsigned value);
+
+	//allocates a physical register for the destination of the instruction in ROB entry "rob_index" (if it has one)
+	void allocate_register(unsigned rob_index);
+
+	//releases the physical register of a squashed instruction
+	void release_register(unsigned rob_index);
+
+	//updates the retirement map when the instruction in ROB entry "rob_index" commits, freeing the previous mapping
+	void retire_register(unsigned rob_index);
+
+	//decoupled front-end (disabled by default: issue reads the instruction memory directly)
+	bool frontend_enabled;
+	unsigned fetch_width;
+	unsigned decode_latency;
+	unsigned fetch_queue_size;
+	unsigned icache_sets;		 // 0: perfect instruction cache
+	unsigned icache_assoc;
+	unsigned icache_line;
+	unsigned icache_miss_latency;
+	unsigned *icache_tags;		 // tags[set * assoc + way] (UNDEFINED if invalid)
+	unsigned *icache_last_use;	 // LRU timestamps
+	unsigned icache_use_counter;
+	unsigned loop_buffer_size;	 // instructions (0: no loop buffer)
+	frontend_stats_t frontend_stats;
+
+	//fetches the instructions of one thread into its fetch queue
+	void fetch();
+
+	//true if "address" hits in the instruction cache; on a miss, the line is filled
+	bool icache_access(unsigned address);
+
+	//true if the instruction at "pc" is at the head of the fetch queue of "thread" and decoded
+	bool fetched(unsigned thread, unsigned pc);
+
+	//removes the head of the fetch queue of "thread" (the instruction issued), and keeps its next_pc in issue_next_pc
+	void pop_fetch_queue(unsigned thread);
+
+	//PC issued after the instruction at "pc" just issued by the issue thread: the path of the fetch queue with the
+	//decoupled front-end, the next instruction otherwise (branches are predicted not taken)
+	unsigned next_issue_pc(unsigned pc);
+
+	//discards the fetch queue of "thread" and restarts fetching from "pc", the target of the mispredicted branch at
+	//"branch_pc"; a short backward branch taken LOOP_DETECT_ITERATIONS times in a row captures its loop in the loop buffer
+	void redirect_fetch(unsigned thread, unsigned pc, unsigned branch_pc);
+
+	//post-commit store buffer (disabled by default: a store takes the memory unit when it commits)
+	unsigned store_buffer_size;			// entries (0: no store buffer)
+	unsigned store_drain_cycles;		// clock cycles to write an entry to memory
+	unsigned store_line_size;			// bytes combined into an entry
+	store_buffer_entry_t *store_buffer; // circular queue, oldest entry first
+	unsigned store_buffer_head;
+	unsigned store_buffer_count;
+	store_buffer_stats_t store_buffer_stats;
+
+	//puts the committed store at "pc" to "address" into the store buffer, combining it with a waiting entry of the
+	//same line; returns false if the buffer is full
+	bool buffer_store(unsigned address, unsigned pc);
+
+	//writes the oldest entry of the store buffer to memory, one entry at a time
+	void drain_store_buffer();
+
+	//scheduler: select policy, next issue sequence number, order in which the reservation stations are examined
+	select_policy_t select_policy;
+	unsigned long long issue_sequence;
+	unsigned *select_order;
+	unsigned long long *select_keys;
+	unsigned select_seed;
+
+	//fills select_order according to the select policy
+	void schedule();
+
+	//marks the oldest instruction of each thread that has not completed yet (critical-path-first policy)
+	void mark_critical();
+
+	//updates the criticality counter of the instruction in ROB entry "rob_index" when it commits
+	void train_criticality(unsigned rob_index);
+
+	//reads vector register "reg" of the issuing thread into an operand of a reservation station: the lanes and a 0
+	//in "value" if it is available, otherwise the ROB entry that will write it in "tag"
+	void read_vector_operand(unsigned reg, unsigned *lanes, unsigned *value, rs_tag_t *tag);
+
+	//operand tags of the reservation stations in structure-of-arrays layout: rs_tags[operand][station], NO_TAG if
+	//the operand is available. Each array is padded with NO_TAG to a multiple of 64 entries, so that the CDB broadcast
+	//and the ready check compare 16 or 32 tags at a time with host SIMD instructions
+	rs_tag_t *rs_tags[NUM_RS_OPERANDS];
+	unsigned rs_slots;		   // padded number of reservation stations
+	unsigned long long *rs_valid; // bitmap of the busy reservation stations
+	unsigned long long *rs_ready; // bitmap of the busy reservation stations with all the operands available (see find_ready)
+	unsigned long long *rs_match; // scratch bitmap
+	bool simd_enabled;
+
+	//sets "matches" to the bitmap of the reservation stations whose operand "operand" has tag "tag"
+	void match_tags(unsigned operand, rs_tag_t tag, unsigned long long *matches);
+
+	//computes rs_ready
+	void find_ready();
+
+	//clears reservation station "index" and its operand tags
+	void free_res_station(unsigned index);
+
+	//CDB broadcast: the operands waiting for ROB entry "tag" capture "value" (and the lanes of a vector result)
+	void broadcast(unsigned tag, unsigned value, const unsigned *lanes);
+
+	//allocates the ROB, the instruction window and the reservation stations (see the constructor)
+	void init_window(unsigned rob_size, unsigned num_int_res_stations, unsigned num_add_res_stations, unsigned num_mul_res_stations, unsigned num_load_res_stations, unsigned num_vector_res_stations);
+
+	//stall flags
+	bool issue_struct_stall;
+	stall_cause_t issue_stall_cause;
+	unsigned issue_stall_pc;
+
 	/* end added data members */
 
 	//issue width
@@ -176,15 +631,28 @@ class sim_ooo
 	unit_t exec_units[MAX_UNITS];
 	unsigned num_units;
 
-	//instruction memory
-	instruction_t instr_memory[PROGRAM_SIZE];
-
-	//base address in the instruction memory where the program is loaded
-	unsigned instr_base_address;
-
 	//data memory - should be initialize to all 0xFF
 	unsigned char *data_memory;
 
+	//false if the data memory is shared with other cores (see attach_memory)
+	bool owns_memory;
+
+	//if false, the loaders return their errors instead of terminating the program (see exit_on_load_error)
+	bool exit_on_error;
+	string load_error;
+
+	//reports an error of a loader: prints it and terminates the program, or saves it and returns false
+	bool load_failed(const string &message);
+	bool state_error(const char *filename, unsigned line_nr, const string &message);
+
+	//memory hierarchy timing model (NULL: fixed latency of the memory unit) and id of the core in it
+	memory_hierarchy *hierarchy;
+	unsigned core_id;
+
+	//word accesses of the loads and stores, through the memory hierarchy if it serves them
+	unsigned load_word(unsigned address);
+	void store_word(unsigned address, unsigned value);
+
 	//memory size in bytes
 	unsigned data_memory_size;
 
@@ -207,16 +675,30 @@ public:
 			unsigned num_add_res_stations, // number of ADD reservation stations
 			unsigned num_mul_res_stations, // number of MULT/DIV reservation stations
 			unsigned num_load_buffers,	   // number of LOAD buffers
-			unsigned issue_width = 1	   // issue width
+			unsigned issue_width = 1,	   // issue width
+			unsigned num_vector_res_stations = 0 // number of VECTOR reservation stations (needed by ADDV, SUBV and MULV)
 	);
 
 	//de-allocates the simulator
 	~sim_ooo();
 
+	//changes the configuration of the processor (same parameters as the constructor, except the data memory) and
+	//resets it; the execution units are removed and all the modes go back to their defaults (single thread, no
+	//front-end, no register file, reservation station select order, no store buffer, no histograms or profiler,
+	//default energy table). The attached memory and memory hierarchy are kept. Used to reuse an instance for many
+	//short simulations
+	void reconfigure(unsigned rob_size,
+					 unsigned num_int_res_stations,
+					 unsigned num_add_res_stations,
+					 unsigned num_mul_res_stations,
+					 unsigned num_load_buffers,
+					 unsigned issue_width = 1,
+					 unsigned num_vector_res_stations = 0);
+
 	// adds one or more execution units of a given type to the processor
 	// - exec_unit: type of execution unit to be added
 	// - latency: latency of the execution unit (in clock cycles)
-	// - instances: number of execution units of this type to be added
+	// - instances: number of execution units of this type to be added (the processor has at most MAX_UNITS units)
 	void init_exec_unit(exe_unit_t exec_unit, unsigned latency, unsigned instances = 1);
 
 	//related to functional unit
@@ -226,12 +708,52 @@ public:
 	void decrement_units_busy_time();
 	void debug_units();
 
+	//sets the number of hardware threads sharing the processor (1 by default) and resets the simulator,
+	//so it must be called before loading the programs
+	// - fetch: policy used to select the thread that issues in each clock cycle
+	// - partition_rob: if true, each thread can only use an equal share of the ROB entries
+	void init_threads(unsigned threads, fetch_policy_t fetch = FETCH_ROUND_ROBIN, bool partition_rob = false);
+
 	//loads the assembly program in file "filename" in instruction memory at the specified address
-	void load_program(const char *filename, unsigned base_address = 0x0);
+	//returns false on an error if exit_on_load_error(false) was called (otherwise an error terminates the program)
+	bool load_program(const char *filename, unsigned base_address = 0x0, unsigned thread = 0);
+
+	//loads initial register and memory values from file "filename"; each line is one of
+	//   R<n> <value>          integer register
+	//   F<n> <value>          floating point register
+	//   V<n> <v0> <v1> <v2> <v3>  vector register (one value per lane)
+	//   M <address> <value>   32-bit word in data memory (stored as a float if the value contains a '.')
+	//   image <address> <file>  memory image (see load_memory_image)
+	//empty lines and lines starting with '#' are ignored; errors are handled as in load_program
+	bool load_state(const char *filename, unsigned thread = 0);
+
+	//same as above, reading the lines from "in" ("filename" is only used in the error messages)
+	bool load_state(istream &in, const char *filename, unsigned thread = 0);
+
+	//by default, an error in a program, state file or memory image prints a message and terminates the program;
+	//if "exit" is false, the loaders return false instead, and the message is returned by get_load_error
+	void exit_on_load_error(bool exit);
+
+	//returns the message of the last loader error
+	string get_load_error();
 
 	//runs the simulator for "cycles" clock cycles (run the program to completion if cycles=0)
 	void run(unsigned cycles = 0);
 
+	//runs the program until it completes or the clock reaches "max_cycles" clock cycles; returns true if it completed
+	bool run_until(unsigned max_cycles);
+
+	//true when all the instructions of the program have left the ROB
+	bool program_completed();
+
+	//replaces the private data memory with "memory" (not de-allocated by the simulator), so that several cores can share it
+	//note: reset() fills the attached memory with 0xFF
+	void attach_memory(unsigned char *memory, unsigned mem_size);
+
+	//models the timing of the loads and stores with "hierarchy" (NULL to restore the fixed latency of the memory unit)
+	// - core: id of this core in the memory hierarchy
+	void set_memory_hierarchy(memory_hierarchy *hierarchy, unsigned core = 0);
+
 	//resets the state of the simulator
 	/* Note: 
 	   - registers should be reset to UNDEFINED value 
@@ -241,22 +763,39 @@ public:
 	void reset();
 
 	//returns value of the specified integer general purpose register
-	int get_int_register(unsigned reg);
+	int get_int_register(unsigned reg, unsigned thread = 0);
 
 	//set the value of the given integer general purpose register to "value"
-	void set_int_register(unsigned reg, int value);
+	void set_int_register(unsigned reg, int value, unsigned thread = 0);
 
 	//returns value of the specified floating point general purpose register
-	float get_fp_register(unsigned reg);
+	float get_fp_register(unsigned reg, unsigned thread = 0);
 
 	//set the value of the given floating point general purpose register to "value"
-	void set_fp_register(unsigned reg, float value);
+	void set_fp_register(unsigned reg, float value, unsigned thread = 0);
 
 	// returns the index of the ROB entry that will write this integer register (UNDEFINED if the value of the register is not pending
-	unsigned get_int_register_tag(unsigned reg);
+	unsigned get_int_register_tag(unsigned reg, unsigned thread = 0);
 
 	// returns the index of the ROB entry that will write this floating point register (UNDEFINED if the value of the register is not pending
-	unsigned get_fp_register_tag(unsigned reg);
+	unsigned get_fp_register_tag(unsigned reg, unsigned thread = 0);
+
+	//returns lane "lane" of the specified vector register
+	float get_vector_register(unsigned reg, unsigned lane, unsigned thread = 0);
+
+	//set lane "lane" of the given vector register to "value"
+	void set_vector_register(unsigned reg, unsigned lane, float value, unsigned thread = 0);
+
+	// returns the index of the ROB entry that will write this vector register (UNDEFINED if the value of the register is not pending
+	unsigned get_vector_register_tag(unsigned reg, unsigned thread = 0);
+
+	//executes the program functionally from the current register and memory state (which is left untouched)
+	//and returns the length of its true-dependence critical path, assuming infinite resources and perfect branch prediction
+	// - max_instructions: stops the analysis after this many instructions (0 = run to EOP)
+	dataflow_limit_t get_dataflow_limit(unsigned long long max_instructions = 0, unsigned thread = 0);
+
+	//prints the dataflow limit of the program (ideal IPC with unit latencies and with the execution unit latencies)
+	void print_dataflow_limit(unsigned long long max_instructions = 0, unsigned thread = 0);
 
 	//returns the IPC
 	float get_IPC();
@@ -267,12 +806,140 @@ public:
 	//returns the number of clock cycles
 	unsigned get_clock_cycles();
 
+	//enables the decoupled front-end and resets the simulator; each clock cycle one thread (round-robin) fetches up
+	//to "width" sequential instructions, predicting branches not taken, into its fetch queue of "queue_size" entries;
+	//an instruction can issue "decode" clock cycles after the one following its fetch. A fetch block does not cross an
+	//instruction cache line. "icache_size" = 0 models a perfect instruction cache; width = 0 disables the front-end
+	void init_frontend(unsigned width, unsigned decode, unsigned queue_size, unsigned icache_size = 0, unsigned icache_assoc = 1, unsigned icache_line = 32, unsigned miss_latency = 10);
+
+	//adds to the decoupled front-end a loop buffer of "size" instructions (0 removes it), and resets the simulator. A
+	//loop closed by a backward branch, no longer than the buffer, is captured when the branch is taken
+	//LOOP_DETECT_ITERATIONS times in a row; while fetch is within the captured loop, the buffer delivers its decoded
+	//instructions to the fetch queue without accessing the instruction cache, ready to issue in the next clock cycle,
+	//and replays the loop: its closing branch is predicted taken, so that only the loop exit is mispredicted
+	void init_loop_buffer(unsigned size);
+
+	//returns the statistics of the decoupled front-end
+	frontend_stats_t get_frontend_stats();
+
+	//prints the configuration and the statistics of the decoupled front-end
+	void print_frontend_stats();
+
+	//adds a post-commit store buffer of "entries" entries (0 removes it) and resets the simulator. A store commits as
+	//soon as it finds room in the buffer, without taking the memory unit, and its value is written to the data memory
+	//right away (later loads read it there). In the background, the buffer writes its oldest entry to memory in
+	//"drain_cycles" clock cycles (plus the latency of the memory hierarchy, if any); a store to a line of "line" bytes
+	//held by an entry that is not draining yet is combined into it. The program completes once the buffer is empty
+	void init_store_buffer(unsigned entries, unsigned drain_cycles = 1, unsigned line = 32);
+
+	//returns the statistics of the store buffer
+	store_buffer_stats_t get_store_buffer_stats();
+
+	//prints the configuration and the statistics of the store buffer
+	void print_store_buffer_stats();
+
+	//enables/disables idle cycle skipping: when an instruction waits for a long-latency unit and nothing else can
+	//happen, run() jumps to the clock cycle in which the next unit completes instead of simulating the cycles in
+	//between one by one (the logs and the statistics are the same). Only used with a single thread and no front-end
+	void enable_idle_skipping(bool enable = true);
+
+	//returns the number of idle clock cycles skipped
+	unsigned long long get_skipped_cycles();
+
+	//selects the host SIMD (SSE2, or AVX2 if the host supports it) or the scalar implementation of the tag compares
+	//of the CDB broadcast and of the ready check (SIMD by default); the simulated timing is the same
+	void enable_simd(bool enable = true);
+
+	//sets the policy used to select among the ready instructions competing for the execution units (reservation
+	//station order by default); the criticality predictor of SELECT_CRITICAL_FIRST counts up when an instruction
+	//reached the head of the ROB before completing, and down otherwise
+	void set_select_policy(select_policy_t policy);
+
+	//enables the merged register file mode, with "int_regs" integer and "fp_regs" floating point physical registers
+	//(0 disables it), and resets the simulator; each thread needs NUM_GP_REGISTERS registers of each file to hold its
+	//committed state, so the files must be larger than that
+	void init_prf(unsigned int_regs, unsigned fp_regs);
+
+	//returns the clock cycles in which issue stalled because the free list of a register file was empty
+	unsigned long long get_prf_stall_cycles(prf_type_t type);
+
+	//prints the size, allocations, minimum free registers and free-list stall cycles of each register file
+	void print_prf_stats();
+
+	//enables/disables move elimination: zero idioms (XOR or SUB of a register with itself), register moves (ADDI
+	//with a 0 immediate) and immediate loads (ADDI from a register holding 0) are resolved at rename when the value
+	//of their source is known at issue. They write their result in the ROB in the issue cycle, without taking a
+	//reservation station or an execution unit, and commit in order as usual
+	void enable_move_elimination(bool enable = true);
+
+	//returns the number of instructions resolved at rename (squashed ones included)
+	unsigned long long get_eliminated_instructions();
+
+	//prints the zero idioms and the moves eliminated
+	void print_elimination_stats();
+
+	//enables/disables macro-op fusion: the pairs marked when the program is decoded (ADDI/SUBI followed by a
+	//conditional branch on its result, or by an LW/LWS using its result as base address) issue in one slot as one
+	//micro-op, which takes one reservation station and one execution unit operation (the integer unit for branch
+	//pairs, the memory unit for load pairs). Each instruction of the pair keeps its ROB entry and commits as usual;
+	//the result of the ADDI/SUBI of a load pair is written with the loaded value
+	void enable_fusion(bool enable = true);
+
+	//returns the number of pairs issued fused (squashed ones included)
+	unsigned long long get_fused_pairs();
+
+	//prints the fused branch and load pairs
+	void print_fusion_stats();
+
+	//energy model: the events of each run are always counted, and weighted by an energy table when the estimate is
+	//requested. The defaults are rough figures for a small core, to be replaced with the ones of the target technology
+	// - set_event_energy: energy of an event (pJ)
+	// - set_unit_energy: energy of an operation of an execution unit type (pJ)
+	// - set_leakage: leakage of a structure per entry and clock cycle (pJ)
+	// - set_clock_frequency: clock frequency used for the average power (GHz)
+	void set_event_energy(energy_event_t event, double pj);
+	void set_unit_energy(exe_unit_t unit, double pj);
+	void set_leakage(leakage_structure_t structure, double pj);
+	void set_clock_frequency(double ghz);
+
+	//returns the number of events of a type / of operations of an execution unit type
+	unsigned long long get_event_count(energy_event_t event);
+	unsigned long long get_unit_operations(exe_unit_t unit);
+
+	//returns the dynamic, leakage and total energy of the run so far, and its average power
+	energy_t get_energy();
+
+	//prints the events, their energy and the leakage of each structure, the energy per instruction and the average power
+	void print_energy_stats();
+
+	//returns the IPC of a hardware thread, computed over the clock cycles until the thread completed its program
+	float get_thread_IPC(unsigned thread);
+
+	//returns the number of instructions fully executed by a hardware thread
+	unsigned get_thread_instructions_executed(unsigned thread);
+
+	//prints the instructions executed and the IPC of each hardware thread
+	void print_thread_stats();
+
 	//prints the content of the data memory within the specified address range
 	void print_memory(unsigned start_address, unsigned end_address);
 
 	// writes an integer value to data memory at the specified address (use little-endian format: https://en.wikipedia.org/wiki/Endianness)
 	void write_memory(unsigned address, unsigned value);
 
+	//returns the 32-bit value in data memory at the specified address (little-endian)
+	unsigned read_memory(unsigned address);
+
+	//loads the raw content of "filename" into data memory at "base_address"; if the data memory is private and the
+	//address is page-aligned in it, the whole pages of the file are mapped copy-on-write instead of being copied (the
+	//file must not change while the simulator uses them). Note: reset() overwrites the image
+	//errors are handled as in load_program
+	bool load_memory_image(const char *filename, unsigned base_address);
+
+	//writes the raw content of data memory in [start_address, end_address) to "filename", replacing it only once the
+	//whole image is written (so "filename" can be the image mapped under the data memory)
+	void dump_memory_image(const char *filename, unsigned start_address, unsigned end_address);
+
 	//prints the values of the registers
 	void print_registers();
 
@@ -296,6 +963,18 @@ public:
 
 	//print log
 	void print_log();
+
+	//enables/disables the per-cycle occupancy and per-opcode latency histograms
+	void enable_histograms(bool enable = true);
+
+	//writes the histograms collected so far to "filename" in JSON format
+	void dump_histograms(const char *filename);
+
+	//enables/disables the per-PC profiler; when enabled, the profile is printed when run() completes the program
+	void enable_profiler(bool enable = true);
+
+	//prints the source listing annotated with the per-PC profile, sorted by cycle contribution
+	void print_profile();
 };
 
 #endif /*SIM_OOO_H_*/
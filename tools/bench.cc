@@ -0,0 +1,427 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <stdlib.h>
+#include <time.h>
+#include <map>
+
+using namespace std;
+
+/* Simulator throughput benchmark
+   Runs scaled-up versions of the bundled kernels on small and large ROB / issue width
+   configurations and reports the host time per simulated clock cycle and the simulated
+   instructions per host second (KIPS). Results are appended to a file, and each result is
+   compared with the last one recorded for the same kernel and configuration.
+   With -s, nothing is timed: the IPC of every kernel and configuration is printed for each
+   scheduler select policy, with its difference from the default (reservation station order).
+   With -f, nothing is timed: the clock cycles of the dot product kernel with separate MULTS and
+   ADDS and with FMAS are compared on every configuration.
+   With -t, the host time per simulated clock cycle is compared with scalar and SIMD tag matching
+   in the reservation stations, on 32, 128 and 512-entry windows (nothing is recorded).
+   With -e (-m), nothing is timed: the IPC of every kernel and configuration is compared with and
+   without move elimination (macro-op fusion), with the number of instructions eliminated (pairs
+   fused).
+
+   usage: bench [-o <results file>] [-l <label>] [-r <repetitions>] [-k <kernel>] [-s] [-f] [-t] [-e] [-m]
+*/
+
+/* deterministic pseudo-random values in [0,1), so that every run simulates the same work */
+static float next_value(unsigned *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return (float)((*seed >> 8) & 0xFFFF) / 65536;
+}
+
+static void init_sort(sim_ooo *ooo)
+{
+	unsigned seed = 1;
+	ooo->set_int_register(7, 0x80000000);
+	for (unsigned i = 0; i < 64; i++)
+		ooo->write_memory(0xA000 + 4 * i, float2unsigned(100 * next_value(&seed) - 50));
+}
+
+static void init_code_ooo2(sim_ooo *ooo)
+{
+	unsigned seed = 2;
+	for (unsigned i = 0; i < 5; i++)
+		ooo->set_fp_register(i, (float)i);
+	for (unsigned i = 0; i < 0x401; i++)
+		ooo->write_memory(0xA000 + 4 * i, float2unsigned(next_value(&seed)));
+}
+
+static void init_code_ooo3(sim_ooo *ooo)
+{
+	unsigned seed = 3;
+	ooo->set_int_register(0, 0);
+	ooo->set_int_register(2, 2000);
+	ooo->set_int_register(3, 0xA000);
+	for (unsigned i = 1; i < 5; i++)
+		ooo->set_fp_register(i, 0.0);
+	for (unsigned i = 0; i < 2000; i++)
+		ooo->write_memory(0xA000 + 4 * i, float2unsigned(next_value(&seed)));
+}
+
+/* y = a * x + y on 1024 elements (x at 0xA000, y at 0xC000) */
+static void init_saxpy_data(sim_ooo *ooo)
+{
+	unsigned seed = 4;
+	ooo->set_int_register(3, 0xA000);
+	ooo->set_int_register(4, 0xC000);
+	for (unsigned i = 0; i < 1024; i++)
+	{
+		ooo->write_memory(0xA000 + 4 * i, float2unsigned(next_value(&seed)));
+		ooo->write_memory(0xC000 + 4 * i, float2unsigned(next_value(&seed)));
+	}
+}
+
+static void init_saxpy(sim_ooo *ooo)
+{
+	init_saxpy_data(ooo);
+	ooo->set_int_register(2, 1024);
+	ooo->set_fp_register(1, 1.5);
+}
+
+static void init_saxpy_vec(sim_ooo *ooo)
+{
+	init_saxpy_data(ooo);
+	ooo->set_int_register(2, 1024 / VECTOR_LANES);
+	for (unsigned l = 0; l < VECTOR_LANES; l++)
+		ooo->set_vector_register(1, l, 1.5);
+}
+
+/* dot product of two vectors of 1024 elements (x at 0xA000, y at 0xC000), accumulated in F0 */
+static void init_dot(sim_ooo *ooo)
+{
+	init_saxpy_data(ooo);
+	ooo->set_int_register(2, 1024);
+	ooo->set_fp_register(0, 0.0);
+}
+
+typedef struct
+{
+	const char *name;
+	const char *program;
+	void (*init)(sim_ooo *);
+	bool vector; // uses the vector instructions (VECTOR reservation stations and unit)
+} kernel_t;
+
+typedef struct
+{
+	const char *name;
+	unsigned rob_size;
+	unsigned res_stations; // reservation stations of each type
+	unsigned issue_width;
+} config_t;
+
+static const kernel_t kernels[] = {
+	{"sort64", "asm/sort64.asm", init_sort, false},
+	{"code_ooo2_large", "asm/code_ooo2_large.asm", init_code_ooo2, false},
+	{"code_ooo3_x2000", "asm/code_ooo3.asm", init_code_ooo3, false},
+	{"saxpy_x1024", "asm/saxpy.asm", init_saxpy, false},
+	{"saxpy_vec_x1024", "asm/saxpy_vec.asm", init_saxpy_vec, true},
+	{"dot_x1024", "asm/dot.asm", init_dot, false},
+	{"dot_fma_x1024", "asm/dot_fma.asm", init_dot, false},
+};
+
+static const config_t configs[] = {
+	{"rob8_w1", 8, 2, 1},
+	{"rob8_w4", 8, 2, 4},
+	{"rob64_w1", 64, 8, 1},
+	{"rob64_w4", 64, 8, 4},
+};
+
+static const char *select_policy_names[NUM_SELECT_POLICIES] = {"position", "oldest", "random", "critical"};
+
+static sim_ooo *build(const kernel_t *kernel, const config_t *config)
+{
+	sim_ooo *ooo = new sim_ooo(1024 * 1024, config->rob_size, config->res_stations, config->res_stations, config->res_stations, config->res_stations, config->issue_width, kernel->vector ? config->res_stations : 0);
+	ooo->init_exec_unit(INTEGER, 3, 2);
+	ooo->init_exec_unit(ADDER, 3, 2);
+	ooo->init_exec_unit(MULTIPLIER, 10, 1);
+	ooo->init_exec_unit(DIVIDER, 40, 1);
+	ooo->init_exec_unit(MEMORY, 5, 1);
+	ooo->init_exec_unit(FMA, 10, 1);
+	if (kernel->vector)
+		ooo->init_exec_unit(VECTOR, 10, 1);
+	ooo->load_program(kernel->program, 0x00000000);
+	kernel->init(ooo);
+	return ooo;
+}
+
+/* IPC of each kernel and configuration under each select policy */
+static void compare_select_policies(const string &only)
+{
+	cout << setfill(' ') << left << setw(18) << "Kernel" << setw(10) << "Config" << right;
+	for (unsigned p = 0; p < NUM_SELECT_POLICIES; p++)
+		cout << setw(p ? 16 : 9) << select_policy_names[p];
+	cout << endl;
+	for (unsigned k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		if (!only.empty() && only != kernels[k].name)
+			continue;
+		for (unsigned c = 0; c < sizeof(configs) / sizeof(configs[0]); c++)
+		{
+			float base = 0;
+			cout << left << setw(18) << kernels[k].name << setw(10) << configs[c].name << right << fixed << setprecision(3);
+			for (unsigned p = 0; p < NUM_SELECT_POLICIES; p++)
+			{
+				sim_ooo *ooo = build(&kernels[k], &configs[c]);
+				ooo->set_select_policy((select_policy_t)p);
+				ooo->run();
+				float ipc = ooo->get_IPC();
+				delete ooo;
+				if (p == 0)
+				{
+					base = ipc;
+					cout << setw(9) << ipc;
+				}
+				else
+					cout << setw(8) << ipc << " (" << showpos << setprecision(1) << setw(5) << 100 * (ipc - base) / base << noshowpos << setprecision(3) << "%)";
+			}
+			cout << endl;
+		}
+	}
+}
+
+/* clock cycles of the dot product with and without multiply-add fusion */
+static void compare_fusion()
+{
+	const kernel_t *separate = NULL, *fused = NULL;
+	for (unsigned k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		if (string(kernels[k].name) == "dot_x1024")
+			separate = &kernels[k];
+		else if (string(kernels[k].name) == "dot_fma_x1024")
+			fused = &kernels[k];
+	}
+	cout << setfill(' ') << left << setw(10) << "Config" << right << setw(14) << "MULTS+ADDS" << setw(10) << "FMAS" << setw(10) << "Speedup" << setw(14) << "Result diff" << endl;
+	for (unsigned c = 0; c < sizeof(configs) / sizeof(configs[0]); c++)
+	{
+		sim_ooo *ooo = build(separate, &configs[c]);
+		ooo->run();
+		unsigned separate_cycles = ooo->get_clock_cycles();
+		float separate_result = ooo->get_fp_register(0);
+		delete ooo;
+		ooo = build(fused, &configs[c]);
+		ooo->run();
+		unsigned fused_cycles = ooo->get_clock_cycles();
+		float fused_result = ooo->get_fp_register(0);
+		delete ooo;
+		cout << left << setw(10) << configs[c].name << right << setw(14) << separate_cycles << setw(10) << fused_cycles;
+		cout << setw(10) << fixed << setprecision(3) << (float)separate_cycles / fused_cycles << setw(14) << scientific << setprecision(2) << fused_result - separate_result << endl;
+	}
+}
+
+/* optimizations compared by -e and -m */
+static void enable_move_elimination(sim_ooo *ooo) { ooo->enable_move_elimination(); }
+static unsigned long long eliminated_instructions(sim_ooo *ooo) { return ooo->get_eliminated_instructions(); }
+static void enable_fusion(sim_ooo *ooo) { ooo->enable_fusion(); }
+static unsigned long long fused_pairs(sim_ooo *ooo) { return ooo->get_fused_pairs(); }
+
+/* IPC of each kernel and configuration with and without an optimization, with its event count */
+static void compare_optimization(const string &only, const char *name, const char *events, void (*enable)(sim_ooo *), unsigned long long (*count)(sim_ooo *))
+{
+	cout << setfill(' ') << left << setw(18) << "Kernel" << setw(10) << "Config" << right << setw(9) << "Base" << setw(16) << name << setw(12) << events << endl;
+	for (unsigned k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		if (!only.empty() && only != kernels[k].name)
+			continue;
+		for (unsigned c = 0; c < sizeof(configs) / sizeof(configs[0]); c++)
+		{
+			sim_ooo *ooo = build(&kernels[k], &configs[c]);
+			ooo->run();
+			float base = ooo->get_IPC();
+			delete ooo;
+			ooo = build(&kernels[k], &configs[c]);
+			enable(ooo);
+			ooo->run();
+			float ipc = ooo->get_IPC();
+			unsigned long long n = count(ooo);
+			delete ooo;
+			cout << left << setw(18) << kernels[k].name << setw(10) << configs[c].name << right << fixed << setprecision(3) << setw(9) << base;
+			cout << setw(8) << ipc << " (" << showpos << setprecision(1) << setw(5) << 100 * (ipc - base) / base << noshowpos << setprecision(3) << "%)" << setw(12) << n << endl;
+		}
+	}
+}
+
+static double now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* host time per simulated clock cycle with scalar and SIMD tag matching, on large instruction windows
+   (ROB of 32, 128 and 512 entries, with as many reservation stations split among the four types) */
+static void compare_tag_matching(const string &only, unsigned repetitions)
+{
+	static const config_t windows[] = {
+		{"rob32_w4", 32, 8, 4},
+		{"rob128_w4", 128, 32, 4},
+		{"rob512_w4", 512, 128, 4},
+	};
+	cout << setfill(' ') << left << setw(18) << "Kernel" << setw(11) << "Config" << right << setw(10) << "Cycles" << setw(14) << "Scalar ns/c" << setw(12) << "SIMD ns/c" << setw(10) << "Speedup" << endl;
+	for (unsigned k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		if (!only.empty() && only != kernels[k].name)
+			continue;
+		for (unsigned c = 0; c < sizeof(windows) / sizeof(windows[0]); c++)
+		{
+			double best[2] = {0, 0};
+			unsigned cycles[2] = {0, 0};
+			for (unsigned r = 0; r < repetitions; r++)
+			{
+				for (unsigned simd = 0; simd < 2; simd++)
+				{
+					sim_ooo *ooo = build(&kernels[k], &windows[c]);
+					ooo->enable_simd(simd);
+					double start = now_ns();
+					ooo->run();
+					double elapsed = now_ns() - start;
+					cycles[simd] = ooo->get_clock_cycles();
+					if (r == 0 || elapsed < best[simd])
+						best[simd] = elapsed;
+					delete ooo;
+				}
+			}
+			if (cycles[0] != cycles[1])
+				cerr << "warning: " << kernels[k].name << " " << windows[c].name << " scalar and SIMD runs differ (" << cycles[0] << " vs " << cycles[1] << " cycles)" << endl;
+			cout << left << setw(18) << kernels[k].name << setw(11) << windows[c].name << right << setw(10) << cycles[1] << fixed << setprecision(1);
+			cout << setw(14) << best[0] / cycles[0] << setw(12) << best[1] / cycles[1] << setw(10) << setprecision(2) << best[0] / best[1] << endl;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *results_file = "bench_output.txt";
+	string label = "local";
+	string only;
+	unsigned repetitions = 3;
+	bool select_policies = false;
+	bool fusion = false;
+	bool tag_matching = false;
+	bool elimination = false;
+	bool macro_fusion = false;
+
+	for (int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "-o" && a + 1 < argc)
+			results_file = argv[++a];
+		else if (arg == "-l" && a + 1 < argc)
+			label = argv[++a];
+		else if (arg == "-r" && a + 1 < argc)
+			repetitions = atoi(argv[++a]);
+		else if (arg == "-k" && a + 1 < argc)
+			only = argv[++a];
+		else if (arg == "-s")
+			select_policies = true;
+		else if (arg == "-f")
+			fusion = true;
+		else if (arg == "-t")
+			tag_matching = true;
+		else if (arg == "-e")
+			elimination = true;
+		else if (arg == "-m")
+			macro_fusion = true;
+		else
+		{
+			cerr << "usage: bench [-o <results file>] [-l <label>] [-r <repetitions>] [-k <kernel>] [-s] [-f] [-t] [-e] [-m]" << endl;
+			return -1;
+		}
+	}
+	if (select_policies)
+	{
+		compare_select_policies(only);
+		return 0;
+	}
+	if (fusion)
+	{
+		compare_fusion();
+		return 0;
+	}
+	if (elimination)
+	{
+		compare_optimization(only, "Elimination", "Eliminated", enable_move_elimination, eliminated_instructions);
+		return 0;
+	}
+	if (macro_fusion)
+	{
+		compare_optimization(only, "Fusion", "Fused", enable_fusion, fused_pairs);
+		return 0;
+	}
+	if (repetitions == 0)
+		repetitions = 1;
+	if (tag_matching)
+	{
+		compare_tag_matching(only, repetitions);
+		return 0;
+	}
+
+	//last recorded KIPS for each kernel/configuration
+	map<string, double> previous;
+	ifstream fin(results_file);
+	string line;
+	while (getline(fin, line))
+	{
+		stringstream ss(line);
+		string time, prev_label, kernel, config;
+		unsigned long long instructions, cycles;
+		double ns_per_cycle, kips;
+		if (ss >> time >> prev_label >> kernel >> config >> instructions >> cycles >> ns_per_cycle >> kips)
+			previous[kernel + " " + config] = kips;
+	}
+	fin.close();
+
+	ofstream fout(results_file, ios::app);
+	if (!fout.is_open())
+	{
+		cerr << "error: open file " << results_file << " failed!" << endl;
+		return -1;
+	}
+
+	cout << setfill(' ') << left << setw(18) << "Kernel" << setw(10) << "Config" << right << setw(10) << "Instr" << setw(10) << "Cycles" << setw(7) << "IPC" << setw(11) << "ns/cycle" << setw(10) << "KIPS" << setw(10) << "Prev" << setw(9) << "Delta" << endl;
+	for (unsigned k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++)
+	{
+		if (!only.empty() && only != kernels[k].name)
+			continue;
+		for (unsigned c = 0; c < sizeof(configs) / sizeof(configs[0]); c++)
+		{
+			const config_t *config = &configs[c];
+			double best = 0;
+			unsigned long long instructions = 0, cycles = 0;
+			for (unsigned r = 0; r < repetitions; r++)
+			{
+				sim_ooo *ooo = build(&kernels[k], config);
+
+				double start = now_ns();
+				ooo->run();
+				double elapsed = now_ns() - start;
+
+				if (r == 0 || elapsed < best)
+					best = elapsed;
+				instructions = ooo->get_instructions_executed();
+				cycles = ooo->get_clock_cycles();
+				delete ooo;
+			}
+			double ns_per_cycle = best / cycles;
+			double kips = instructions / best * 1e6;
+			string key = string(kernels[k].name) + " " + config->name;
+
+			cout << left << setw(18) << kernels[k].name << setw(10) << config->name << right << setw(10) << instructions << setw(10) << cycles;
+			cout << fixed << setprecision(3) << setw(7) << (float)instructions / cycles << setprecision(1) << setw(11) << ns_per_cycle << setw(10) << kips;
+			if (previous.count(key))
+				cout << setw(10) << previous[key] << setw(8) << showpos << 100 * (kips - previous[key]) / previous[key] << noshowpos << "%";
+			else
+				cout << setw(10) << "-" << setw(9) << "-";
+			cout << endl;
+
+			fout << (unsigned long)time(NULL) << " " << label << " " << kernels[k].name << " " << config->name << " " << instructions << " " << cycles << " " << fixed << setprecision(1) << ns_per_cycle << " " << kips << endl;
+		}
+	}
+	cout << endl
+		 << "Results appended to " << results_file << endl;
+	return 0;
+}
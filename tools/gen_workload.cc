@@ -0,0 +1,357 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+/* Synthetic workload generator
+   Emits a parameterized assembly program in the simulator's dialect (<prefix>.asm) and the
+   matching register/memory initialization (<prefix>.init, see sim_ooo::load_state). The loop
+   counts are chosen so that the program executes about the requested number of instructions.
+
+   usage: gen_workload -k <kernel> -o <prefix> [options]
+	kernels:
+	  stream   streaming loads and stores: B[i] = A[i] + c over an array, repeated
+	  chase    pointer chasing through a random cyclic list
+	  reduce   FP reduction trees of width -w over an array, repeated
+	  branch   data-dependent branches, taken with probability -p
+	  chain    long dependency chains of -l instructions (-t int or fp)
+	options:
+	  -d <instructions>  approximate number of dynamic instructions (default 100000)
+	  -n <elements>      array / list size in words (default 1024)
+	  -u <unroll>        unroll factor of the stream and chase loops (default 4)
+	  -w <width>         reduction tree width, power of 2 up to 16 (default 8)
+	  -p <probability>   branch taken probability (default 0.5)
+	  -l <length>        dependency chain length (default 32)
+	  -t int|fp          dependency chain type (default fp)
+	  -s <stride>        distance in bytes between list nodes (default 64)
+	  -m <bytes>         size of the simulated data memory (default 1MB)
+	  -r <seed>          random seed (default 1)
+*/
+
+#define DATA_BASE 0x1000
+#define MAX_PROGRAM (PROGRAM_SIZE - 1) //instructions accepted by sim_ooo::load_program
+
+typedef struct
+{
+	string kernel;
+	unsigned long long instructions;
+	unsigned elements;
+	unsigned unroll;
+	unsigned width;
+	double probability;
+	unsigned length;
+	bool fp_chain;
+	unsigned stride;
+	unsigned memory_size;
+	unsigned seed;
+} params_t;
+
+/* program being generated */
+typedef struct
+{
+	stringstream code;
+	stringstream init;
+	unsigned size;		  // static instructions
+	unsigned long long dynamic; // expected dynamic instructions
+} workload_t;
+
+static void usage()
+{
+	cerr << "usage: gen_workload -k stream|chase|reduce|branch|chain -o <prefix> [-d <instructions>] [-n <elements>] [-u <unroll>]" << endl;
+	cerr << "                    [-w <width>] [-p <probability>] [-l <length>] [-t int|fp] [-s <stride>] [-m <bytes>] [-r <seed>]" << endl;
+	exit(-1);
+}
+
+static void fail(const string &message)
+{
+	cerr << "error: " << message << endl;
+	exit(-1);
+}
+
+/* emits one instruction, optionally labeled */
+static void emit(workload_t *w, const string &instruction, const string &label = "")
+{
+	if (!label.empty())
+		w->code << label << ":";
+	w->code << "\t" << instruction << endl;
+	w->size++;
+}
+
+static string str(const char *format, ...)
+{
+	char buffer[128];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	return buffer;
+}
+
+/* random float in [1,2): never equal to the simulator's UNDEFINED bit pattern */
+static float random_float()
+{
+	return 1.0f + (float)(rand() & 0xFFFF) / 65536;
+}
+
+static unsigned long long div_ceil(unsigned long long a, unsigned long long b)
+{
+	return (a + b - 1) / b;
+}
+
+static void check_array(const params_t &p, unsigned long long bytes)
+{
+	if (DATA_BASE + bytes > p.memory_size)
+		fail("data does not fit in the simulated memory (use a smaller -n or a larger -m)");
+}
+
+/* B[i] = A[i] + c, over and over */
+static void gen_stream(workload_t *w, const params_t &p)
+{
+	unsigned u = p.unroll;
+	if (u == 0 || u > 8 || p.elements % u)
+		fail("stream: the unroll factor must be between 1 and 8 and divide the number of elements");
+	unsigned a = DATA_BASE, b = DATA_BASE + 4 * p.elements;
+	check_array(p, 8ULL * p.elements);
+	unsigned long long per_pass = 3 + (3 * u + 4) * (p.elements / u) + 2;
+	unsigned long long passes = max(1ULL, div_ceil(p.instructions, per_pass));
+
+	emit(w, "XOR R0 R0 R0");
+	emit(w, str("ADDI R5 R0 %llu", passes));
+	emit(w, str("ADDI R1 R0 0x%x", a), "OUTER");
+	emit(w, str("ADDI R2 R0 0x%x", b));
+	emit(w, str("ADDI R3 R0 %u", p.elements / u));
+	for (unsigned i = 0; i < u; i++)
+		emit(w, str("LWS F%u %u(R1)", i + 1, 4 * i), i == 0 ? "LOOP" : "");
+	for (unsigned i = 0; i < u; i++)
+		emit(w, str("ADDS F%u F%u F31", i + 1, i + 1));
+	for (unsigned i = 0; i < u; i++)
+		emit(w, str("SWS F%u %u(R2)", i + 1, 4 * i));
+	emit(w, str("ADDI R1 R1 %u", 4 * u));
+	emit(w, str("ADDI R2 R2 %u", 4 * u));
+	emit(w, "SUBI R3 R3 1");
+	emit(w, "BNEZ R3 LOOP");
+	emit(w, "SUBI R5 R5 1");
+	emit(w, "BNEZ R5 OUTER");
+	w->dynamic = 2 + passes * per_pass;
+
+	w->init << "F31 " << random_float() << endl;
+	for (unsigned i = 0; i < p.elements; i++)
+		w->init << "M 0x" << hex << a + 4 * i << dec << " " << random_float() << endl;
+}
+
+/* walks a random cyclic list: every load depends on the previous one */
+static void gen_chase(workload_t *w, const params_t &p)
+{
+	unsigned u = p.unroll;
+	if (u == 0 || u > 32)
+		fail("chase: the unroll factor must be between 1 and 32");
+	if (p.stride < 4 || p.stride % 4)
+		fail("chase: the stride must be a multiple of 4");
+	check_array(p, (unsigned long long)p.stride * p.elements);
+	vector<unsigned> order(p.elements);
+	for (unsigned i = 0; i < p.elements; i++)
+		order[i] = i;
+	for (unsigned i = p.elements - 1; i > 0; i--)
+		swap(order[i], order[rand() % (i + 1)]);
+	unsigned long long steps = max(1ULL, div_ceil(p.instructions, u + 2));
+
+	emit(w, "XOR R0 R0 R0");
+	emit(w, str("ADDI R1 R0 0x%x", DATA_BASE + order[0] * p.stride));
+	emit(w, str("ADDI R3 R0 %llu", steps));
+	for (unsigned i = 0; i < u; i++)
+		emit(w, "LW R1 0(R1)", i == 0 ? "LOOP" : "");
+	emit(w, "SUBI R3 R3 1");
+	emit(w, "BNEZ R3 LOOP");
+	w->dynamic = 3 + steps * (u + 2);
+
+	for (unsigned i = 0; i < p.elements; i++)
+		w->init << "M 0x" << hex << DATA_BASE + order[i] * p.stride << " 0x" << DATA_BASE + order[(i + 1) % p.elements] * p.stride << dec << endl;
+}
+
+/* sums the array with reduction trees of the given width, accumulating in F0 */
+static void gen_reduce(workload_t *w, const params_t &p)
+{
+	unsigned width = p.width;
+	if (width < 2 || width > 16 || (width & (width - 1)))
+		fail("reduce: the width must be a power of 2 between 2 and 16");
+	if (p.elements % width)
+		fail("reduce: the width must divide the number of elements");
+	check_array(p, 4ULL * p.elements);
+	unsigned long long per_pass = 2 + (2 * width + 3) * (p.elements / width) + 2;
+	unsigned long long passes = max(1ULL, div_ceil(p.instructions, per_pass));
+
+	emit(w, "XOR R0 R0 R0");
+	emit(w, str("ADDI R5 R0 %llu", passes));
+	emit(w, str("ADDI R1 R0 0x%x", DATA_BASE), "OUTER");
+	emit(w, str("ADDI R3 R0 %u", p.elements / width));
+	for (unsigned i = 0; i < width; i++)
+		emit(w, str("LWS F%u %u(R1)", i + 1, 4 * i), i == 0 ? "LOOP" : "");
+	for (unsigned step = 1; step < width; step *= 2)
+		for (unsigned i = 0; i + step < width; i += 2 * step)
+			emit(w, str("ADDS F%u F%u F%u", i + 1, i + 1, i + step + 1));
+	emit(w, "ADDS F0 F0 F1");
+	emit(w, str("ADDI R1 R1 %u", 4 * width));
+	emit(w, "SUBI R3 R3 1");
+	emit(w, "BNEZ R3 LOOP");
+	emit(w, "SUBI R5 R5 1");
+	emit(w, "BNEZ R5 OUTER");
+	w->dynamic = 2 + passes * per_pass;
+
+	w->init << "F0 0.0" << endl;
+	for (unsigned i = 0; i < p.elements; i++)
+		w->init << "M 0x" << hex << DATA_BASE + 4 * i << dec << " " << random_float() << endl;
+}
+
+/* skips a block of work when the flag of the current element is zero */
+static void gen_branch(workload_t *w, const params_t &p)
+{
+	if (p.probability < 0 || p.probability > 1)
+		fail("branch: the probability must be between 0 and 1");
+	check_array(p, 4ULL * p.elements);
+	vector<bool> taken(p.elements);
+	unsigned num_taken = 0;
+	for (unsigned i = 0; i < p.elements; i++)
+	{
+		taken[i] = (double)rand() / RAND_MAX < p.probability;
+		num_taken += taken[i];
+	}
+	unsigned long long per_pass = 2 + 7 * p.elements - 2 * num_taken + 2;
+	unsigned long long passes = max(1ULL, div_ceil(p.instructions, per_pass));
+
+	emit(w, "XOR R0 R0 R0");
+	emit(w, str("ADDI R5 R0 %llu", passes));
+	emit(w, str("ADDI R1 R0 0x%x", DATA_BASE), "OUTER");
+	emit(w, str("ADDI R3 R0 %u", p.elements));
+	emit(w, "LW R4 0(R1)", "LOOP");
+	emit(w, "BEQZ R4 SKIP");
+	emit(w, "ADDS F1 F1 F2");
+	emit(w, "ADDI R6 R6 1");
+	emit(w, "ADDI R1 R1 4", "SKIP");
+	emit(w, "SUBI R3 R3 1");
+	emit(w, "BNEZ R3 LOOP");
+	emit(w, "SUBI R5 R5 1");
+	emit(w, "BNEZ R5 OUTER");
+	w->dynamic = 2 + passes * per_pass;
+
+	w->init << "R6 0" << endl;
+	w->init << "F1 0.0" << endl;
+	w->init << "F2 " << random_float() << endl;
+	for (unsigned i = 0; i < p.elements; i++)
+		w->init << "M 0x" << hex << DATA_BASE + 4 * i << dec << " " << (taken[i] ? 0 : 1) << endl;
+}
+
+/* a loop whose body is a single chain of dependent instructions */
+static void gen_chain(workload_t *w, const params_t &p)
+{
+	if (p.length == 0 || p.length + 8 > MAX_PROGRAM)
+		fail("chain: invalid length");
+	unsigned long long iterations = max(1ULL, div_ceil(p.instructions, p.length + 2));
+
+	emit(w, "XOR R0 R0 R0");
+	emit(w, "ADDI R4 R0 0");
+	emit(w, str("ADDI R3 R0 %llu", iterations));
+	for (unsigned i = 0; i < p.length; i++)
+		emit(w, p.fp_chain ? "ADDS F1 F1 F2" : "ADDI R4 R4 1", i == 0 ? "LOOP" : "");
+	emit(w, "SUBI R3 R3 1");
+	emit(w, "BNEZ R3 LOOP");
+	w->dynamic = 3 + iterations * (p.length + 2);
+
+	w->init << "F1 0.0" << endl;
+	w->init << "F2 " << random_float() << endl;
+}
+
+static void write_file(const string &filename, const string &content)
+{
+	ofstream fout(filename.c_str());
+	if (!fout.is_open())
+		fail("open file " + filename + " failed!");
+	fout << content;
+}
+
+int main(int argc, char **argv)
+{
+	params_t p;
+	p.instructions = 100000;
+	p.elements = 1024;
+	p.unroll = 4;
+	p.width = 8;
+	p.probability = 0.5;
+	p.length = 32;
+	p.fp_chain = true;
+	p.stride = 64;
+	p.memory_size = 1024 * 1024;
+	p.seed = 1;
+	string prefix;
+
+	for (int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (a + 1 == argc)
+			usage();
+		const char *value = argv[++a];
+		if (arg == "-k")
+			p.kernel = value;
+		else if (arg == "-o")
+			prefix = value;
+		else if (arg == "-d")
+			p.instructions = strtoull(value, NULL, 0);
+		else if (arg == "-n")
+			p.elements = strtoul(value, NULL, 0);
+		else if (arg == "-u")
+			p.unroll = strtoul(value, NULL, 0);
+		else if (arg == "-w")
+			p.width = strtoul(value, NULL, 0);
+		else if (arg == "-p")
+			p.probability = atof(value);
+		else if (arg == "-l")
+			p.length = strtoul(value, NULL, 0);
+		else if (arg == "-t")
+			p.fp_chain = string(value) != "int";
+		else if (arg == "-s")
+			p.stride = strtoul(value, NULL, 0);
+		else if (arg == "-m")
+			p.memory_size = strtoul(value, NULL, 0);
+		else if (arg == "-r")
+			p.seed = strtoul(value, NULL, 0);
+		else
+			usage();
+	}
+	if (p.kernel.empty() || prefix.empty() || p.elements == 0)
+		usage();
+	srand(p.seed);
+
+	workload_t w;
+	w.size = 0;
+	w.dynamic = 0;
+	w.init << fixed << setprecision(6);
+	w.init << "# " << p.kernel << " workload, generated by gen_workload" << endl;
+	if (p.kernel == "stream")
+		gen_stream(&w, p);
+	else if (p.kernel == "chase")
+		gen_chase(&w, p);
+	else if (p.kernel == "reduce")
+		gen_reduce(&w, p);
+	else if (p.kernel == "branch")
+		gen_branch(&w, p);
+	else if (p.kernel == "chain")
+		gen_chain(&w, p);
+	else
+		usage();
+	emit(&w, "EOP");
+	if (w.size > MAX_PROGRAM)
+		fail("the program does not fit in the instruction memory");
+
+	write_file(prefix + ".asm", w.code.str());
+	write_file(prefix + ".init", w.init.str());
+	cout << prefix << ".asm: " << w.size << " static instructions, about " << w.dynamic << " dynamic instructions" << endl;
+	return 0;
+}
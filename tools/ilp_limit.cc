@@ -0,0 +1,193 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+
+using namespace std;
+
+/* Dataflow limit (ILP) analyzer
+   Executes an assembly program functionally and reports the critical path of its true
+   dependences (registers and memory) under infinite resources, both with unit latencies
+   and with the latencies of the execution units. With -c, the program is also simulated
+   on the given configuration, to show how far the configuration is from the limit.
+
+   usage: ilp_limit <program.asm> [options]
+	-R<n>=<value>        initial value of integer register Rn
+	-F<n>=<value>        initial value of floating point register Fn
+	-M<address>=<value>  initial value of the memory word at address (floats are stored as floats)
+	-i <file>            initial registers and memory from a file (see sim_ooo::load_state)
+	-u <UNIT>=<latency>[x<instances>]  execution unit (INTEGER, ADDER, MULTIPLIER, DIVIDER, MEMORY, VECTOR, FMA)
+	-c <rob>,<int>,<add>,<mult>,<load>[,<issue width>[,<vector>]]  simulate this configuration
+	-r <int regs>,<fp regs>  simulate it with merged physical register files of these sizes
+	-f <width>,<decode>,<queue>[,<icache size>,<assoc>,<line>,<miss latency>]  simulate it with a decoupled front-end
+	-n <instructions>    stop the analysis after this many instructions
+*/
+
+static void usage()
+{
+	cerr << "usage: ilp_limit <program.asm> [-R<n>=<value>] [-F<n>=<value>] [-M<address>=<value>] [-i <file>]" << endl;
+	cerr << "                 [-u <UNIT>=<latency>[x<instances>]] [-c <rob>,<int>,<add>,<mult>,<load>[,<width>[,<vector>]]]" << endl;
+	cerr << "                 [-r <int regs>,<fp regs>] [-f <width>,<decode>,<queue>[,<icache size>,<assoc>,<line>,<miss>]] [-n <instructions>]" << endl;
+	exit(-1);
+}
+
+/* parses "<UNIT>=<latency>[x<instances>]" */
+static bool parse_unit(const string &arg, exe_unit_t *type, unsigned *latency, unsigned *instances)
+{
+	static const char *names[NUM_UNIT_TYPES] = {"INTEGER", "ADDER", "MULTIPLIER", "DIVIDER", "MEMORY", "VECTOR", "FMA"};
+	size_t eq = arg.find('=');
+	if (eq == string::npos)
+		return false;
+	for (unsigned t = 0; t < NUM_UNIT_TYPES; t++)
+	{
+		if (arg.substr(0, eq) == names[t])
+		{
+			*type = (exe_unit_t)t;
+			*instances = 1;
+			if (sscanf(arg.c_str() + eq + 1, "%ux%u", latency, instances) < 1)
+				return false;
+			return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+		usage();
+
+	unsigned config[7] = {0, 0, 0, 0, 0, 1, 0};
+	unsigned num_config = 0;
+	unsigned prf[2] = {0, 0};
+	unsigned frontend[7] = {0, 0, 0, 0, 1, 32, 10};
+	unsigned long long max_instructions = 0;
+	bool custom_units = false;
+	exe_unit_t unit_types[MAX_UNITS];
+	unsigned unit_latencies[MAX_UNITS], unit_instances[MAX_UNITS];
+	unsigned num_unit_args = 0;
+
+	//first pass: configuration
+	for (int a = 2; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "-u" && a + 1 < argc)
+		{
+			if (num_unit_args == MAX_UNITS || !parse_unit(argv[++a], &unit_types[num_unit_args], &unit_latencies[num_unit_args], &unit_instances[num_unit_args]))
+				usage();
+			num_unit_args++;
+			custom_units = true;
+		}
+		else if (arg == "-c" && a + 1 < argc)
+		{
+			stringstream ss(argv[++a]);
+			string field;
+			while (num_config < 7 && getline(ss, field, ','))
+				config[num_config++] = strtoul(field.c_str(), NULL, 0);
+			if (num_config < 5)
+				usage();
+		}
+		else if (arg == "-r" && a + 1 < argc)
+		{
+			if (sscanf(argv[++a], "%u,%u", &prf[0], &prf[1]) != 2)
+				usage();
+		}
+		else if (arg == "-f" && a + 1 < argc)
+		{
+			stringstream ss(argv[++a]);
+			string field;
+			unsigned n = 0;
+			while (n < 7 && getline(ss, field, ','))
+				frontend[n++] = strtoul(field.c_str(), NULL, 0);
+			if (n != 3 && n != 7)
+				usage();
+		}
+		else if (arg == "-n" && a + 1 < argc)
+			max_instructions = strtoull(argv[++a], NULL, 0);
+	}
+
+	sim_ooo *ooo;
+	if (num_config)
+		ooo = new sim_ooo(1024 * 1024, config[0], config[1], config[2], config[3], config[4], config[5], config[6]);
+	else
+		ooo = new sim_ooo(1024 * 1024, 1, 1, 1, 1, 1, 1, 1);
+
+	if (custom_units)
+	{
+		for (unsigned u = 0; u < num_unit_args; u++)
+			ooo->init_exec_unit(unit_types[u], unit_latencies[u], unit_instances[u]);
+	}
+	else
+	{
+		ooo->init_exec_unit(INTEGER, 2, 1);
+		ooo->init_exec_unit(ADDER, 2, 2);
+		ooo->init_exec_unit(MULTIPLIER, 10, 1);
+		ooo->init_exec_unit(DIVIDER, 40, 1);
+		ooo->init_exec_unit(MEMORY, 1, 1);
+		ooo->init_exec_unit(VECTOR, 4, 1);
+		ooo->init_exec_unit(FMA, 4, 1);
+	}
+
+	if (prf[0] || prf[1])
+		ooo->init_prf(prf[0], prf[1]);
+	if (frontend[0])
+		ooo->init_frontend(frontend[0], frontend[1], frontend[2], frontend[3], frontend[4], frontend[5], frontend[6]);
+	ooo->load_program(argv[1], 0x00000000);
+
+	//second pass: initial state
+	for (int a = 2; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "-i" && a + 1 < argc)
+		{
+			ooo->load_state(argv[++a]);
+			continue;
+		}
+		if (arg == "-u" || arg == "-c" || arg == "-r" || arg == "-f" || arg == "-n")
+		{
+			a++;
+			continue;
+		}
+		size_t eq = arg.find('=');
+		if (arg.length() < 3 || arg[0] != '-' || eq == string::npos)
+			usage();
+		unsigned target = strtoul(arg.substr(2, eq - 2).c_str(), NULL, 0);
+		string value = arg.substr(eq + 1);
+		bool is_float = value.find('.') != string::npos;
+		switch (arg[1])
+		{
+		case 'R':
+			ooo->set_int_register(target, strtol(value.c_str(), NULL, 0));
+			break;
+		case 'F':
+			ooo->set_fp_register(target, atof(value.c_str()));
+			break;
+		case 'M':
+			ooo->write_memory(target, is_float ? float2unsigned(atof(value.c_str())) : strtoul(value.c_str(), NULL, 0));
+			break;
+		default:
+			usage();
+		}
+	}
+
+	dataflow_limit_t limit = ooo->get_dataflow_limit(max_instructions);
+	ooo->print_dataflow_limit(max_instructions);
+
+	if (num_config)
+	{
+		ooo->run();
+		float ideal = limit.critical_path_latency ? (float)limit.instructions / limit.critical_path_latency : 0;
+		cout << "SIMULATED CONFIGURATION" << endl;
+		cout << "Instruction executed = " << dec << ooo->get_instructions_executed() << endl;
+		cout << "Clock cycles = " << ooo->get_clock_cycles() << endl;
+		cout << "IPC = " << ooo->get_IPC() << endl;
+		if (ideal > 0)
+			cout << "Fraction of the dataflow limit = " << ooo->get_IPC() / ideal << endl;
+		if (prf[0] || prf[1] || frontend[0])
+			cout << endl;
+		ooo->print_prf_stats();
+		ooo->print_frontend_stats();
+	}
+
+	delete ooo;
+}
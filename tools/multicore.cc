@@ -0,0 +1,187 @@
+#include "sim_multicore.h"
+#include <iostream>
+#include <stdlib.h>
+#include <sstream>
+#include <vector>
+#include <iomanip>
+#include <time.h>
+
+using namespace std;
+
+/* Multicore simulator
+   Runs one assembly program per core on a system of identical cores sharing the data memory
+   through private MESI caches, and prints the per-core execution and cache statistics and the
+   bus traffic. Programs are assigned to the cores round-robin, so a single program runs on all
+   the cores. Each program can be followed by ":<file>" to load the initial registers and memory
+   of its cores from a file (see sim_ooo::load_state).
+
+   usage: multicore <program.asm>[:<init file>]... [options]
+	-n <cores>                          number of cores (default: number of programs)
+	-p <rob>,<int>,<add>,<mult>,<load>[,<issue width>]  configuration of each core (default 16,4,4,4,4,2)
+	-c <size>,<assoc>,<line>[,<hit>]    private caches (default 8192,4,32,1)
+	-b <bus>,<memory>,<cache-to-cache>  bus, memory and cache-to-cache latencies (default 2,20,5)
+	-f <next|stride|stream>[,<degree>[,<distance>]]  prefetcher of the private caches (default degree 1, distance 1)
+	-m <start>,<end>                    prints the shared memory in this address range at the end
+	-q <quantum>[,<quantum>...]         also runs the system with one host thread per core, for each quantum,
+	                                    and compares speed and simulated cycles with the serial run
+*/
+
+static void usage()
+{
+	cerr << "usage: multicore <program.asm>[:<init file>]... [-n <cores>] [-p <rob>,<int>,<add>,<mult>,<load>[,<width>]]" << endl;
+	cerr << "                 [-c <size>,<assoc>,<line>[,<hit>]] [-b <bus>,<memory>,<c2c>]" << endl;
+	cerr << "                 [-f <next|stride|stream>[,<degree>[,<distance>]]] [-m <start>,<end>] [-q <quantum>[,<quantum>...]]" << endl;
+	exit(-1);
+}
+
+/* parses a comma-separated list of at least "min" and at most "max" numbers */
+static void parse_list(const char *arg, unsigned *values, unsigned min, unsigned max)
+{
+	stringstream ss(arg);
+	string field;
+	unsigned n = 0;
+	while (n < max && getline(ss, field, ','))
+		values[n++] = strtoul(field.c_str(), NULL, 0);
+	if (n < min)
+		usage();
+}
+
+static vector<string> programs, init_files;
+static unsigned num_cores = 0;
+static unsigned core_config[6] = {16, 4, 4, 4, 4, 2};
+static unsigned cache_config[4] = {8192, 4, 32, 1};
+static unsigned bus_config[3] = {2, 20, 5};
+static prefetcher_t prefetcher = PREFETCH_NONE;
+static unsigned prefetch_config[2] = {1, 1};
+
+/* builds the system and loads the programs and their initial state */
+static sim_multicore *build_system()
+{
+	sim_multicore *system = new sim_multicore(num_cores, 1024 * 1024, core_config[0], core_config[1], core_config[2], core_config[3], core_config[4], core_config[5]);
+	system->init_exec_unit(INTEGER, 2, 1);
+	system->init_exec_unit(ADDER, 2, 2);
+	system->init_exec_unit(MULTIPLIER, 10, 1);
+	system->init_exec_unit(DIVIDER, 40, 1);
+	system->init_exec_unit(MEMORY, 1, 1);
+	system->init_caches(cache_config[0], cache_config[1], cache_config[2], cache_config[3]);
+	system->init_bus(bus_config[0], bus_config[1], bus_config[2]);
+	system->init_prefetcher(prefetcher, prefetch_config[0], prefetch_config[1]);
+
+	for (unsigned c = 0; c < num_cores; c++)
+	{
+		sim_ooo *core = system->get_core(c);
+		core->load_program(programs[c % programs.size()].c_str(), 0x00000000);
+		if (!init_files[c % programs.size()].empty())
+			core->load_state(init_files[c % programs.size()].c_str());
+	}
+	return system;
+}
+
+static double now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned dump[2] = {0, 0};
+	unsigned quanta[16];
+	unsigned num_quanta = 0;
+
+	for (int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "-n" && a + 1 < argc)
+			num_cores = atoi(argv[++a]);
+		else if (arg == "-p" && a + 1 < argc)
+			parse_list(argv[++a], core_config, 5, 6);
+		else if (arg == "-c" && a + 1 < argc)
+			parse_list(argv[++a], cache_config, 3, 4);
+		else if (arg == "-b" && a + 1 < argc)
+			parse_list(argv[++a], bus_config, 3, 3);
+		else if (arg == "-f" && a + 1 < argc)
+		{
+			string spec = argv[++a];
+			size_t comma = spec.find(',');
+			string type = spec.substr(0, comma);
+			if (type == "next")
+				prefetcher = PREFETCH_NEXT_LINE;
+			else if (type == "stride")
+				prefetcher = PREFETCH_STRIDE;
+			else if (type == "stream")
+				prefetcher = PREFETCH_STREAM;
+			else
+				usage();
+			if (comma != string::npos)
+				parse_list(spec.c_str() + comma + 1, prefetch_config, 1, 2);
+		}
+		else if (arg == "-m" && a + 1 < argc)
+			parse_list(argv[++a], dump, 2, 2);
+		else if (arg == "-q" && a + 1 < argc)
+		{
+			stringstream ss(argv[++a]);
+			string field;
+			while (num_quanta < 16 && getline(ss, field, ','))
+				quanta[num_quanta++] = strtoul(field.c_str(), NULL, 0);
+		}
+		else if (arg[0] == '-')
+			usage();
+		else
+		{
+			size_t colon = arg.find(':');
+			programs.push_back(arg.substr(0, colon));
+			init_files.push_back(colon == string::npos ? "" : arg.substr(colon + 1));
+		}
+	}
+	if (programs.empty())
+		usage();
+	if (num_cores == 0)
+		num_cores = programs.size();
+
+	sim_multicore *system = build_system();
+	double start = now_ms();
+	system->run();
+	double serial_ms = now_ms() - start;
+	system->print_stats();
+	if (dump[1] > dump[0])
+		system->print_memory(dump[0], dump[1]);
+	unsigned serial_cycles = system->get_clock_cycles();
+	vector<unsigned> core_cycles;
+	for (unsigned c = 0; c < num_cores; c++)
+		core_cycles.push_back(system->get_core(c)->get_clock_cycles());
+	delete system;
+
+	if (num_quanta == 0)
+		return 0;
+
+	//parallel runs: speedup over the serial run, and error of the simulated cycles (system and worst core)
+	cout << dec << setfill(' ');
+	cout << "PARALLEL RUNS (" << num_cores << " host threads, serial run " << fixed << setprecision(1) << serial_ms << " ms)" << endl;
+	cout << setw(8) << "Quantum" << setw(12) << "Time (ms)" << setw(9) << "Speedup" << setw(10) << "Cycles" << setw(9) << "Error%" << setw(13) << "MaxCoreErr%" << setw(10) << "BusTrans" << endl;
+	for (unsigned q = 0; q < num_quanta; q++)
+	{
+		system = build_system();
+		start = now_ms();
+		system->run_parallel(quanta[q]);
+		double parallel_ms = now_ms() - start;
+		unsigned cycles = system->get_clock_cycles();
+		double max_error = 0;
+		for (unsigned c = 0; c < num_cores; c++)
+		{
+			double error = 100.0 * ((double)system->get_core(c)->get_clock_cycles() - core_cycles[c]) / core_cycles[c];
+			if (error < 0)
+				error = -error;
+			max_error = max(max_error, error);
+		}
+		unsigned long long transactions = 0;
+		for (unsigned t = 0; t < NUM_BUS_TRANSACTIONS; t++)
+			transactions += system->get_bus_transactions((bus_transaction_t)t);
+		cout << setw(8) << quanta[q] << setw(12) << setprecision(1) << parallel_ms << setw(9) << setprecision(2) << serial_ms / parallel_ms;
+		cout << setw(10) << cycles << setw(9) << showpos << setprecision(2) << 100.0 * ((double)cycles - serial_cycles) / serial_cycles << noshowpos;
+		cout << setw(13) << max_error << setw(10) << transactions << endl;
+		delete system;
+	}
+	return 0;
+}
@@ -0,0 +1,307 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <glob.h>
+
+using namespace std;
+
+/* Golden-output regression runner
+   Runs all the testcases, bin/simulate on every configuration in configs/, and bin/multicore with
+   the arguments of every .multicore file in configs/, concurrently and compares their output with
+   the reference outputs in testcases/ and testcases/accurate_address_calculation/. The reference
+   of configs/<name>.ini (or configs/<name>.multicore) is <name>.out, so configs/testcase<n>.ini
+   must reproduce testcase<n> exactly. A .multicore file holds the arguments of bin/multicore on
+   its first line that is neither empty nor a '#' comment. A test passes if its output matches
+   one of the reference directories. With -s, only the architectural state printed after the
+   program terminates (registers and data memory) and the execution log are compared.
+   Must be run from the root of the repository (the testcases load asm/ files by relative path).
+
+   usage: regress [-s] [-j <jobs>] [-n <number of testcases>] [-g <reference dir>]... [-v]
+*/
+
+typedef struct
+{
+	string name;			// testcase<n> or configuration file
+	string command;			// command line of the test
+	string reference;		// name of the reference output, without .out
+	string output;			// output of the testcase
+	int status;				// exit status
+	double wall_ms;			// wall time of the testcase
+	int matched;			// index of the matching reference directory (-1 if none)
+	string first_diff;		// first difference with the first reference directory
+} test_result_t;
+
+static double now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* path of the executable of a testcase (native build, or the prebuilt Windows one) */
+static string testcase_binary(unsigned number)
+{
+	stringstream path;
+	path << "bin/testcase" << number;
+	if (access(path.str().c_str(), X_OK) != 0)
+		path << ".exe";
+	return path.str();
+}
+
+static bool read_file(const string &filename, string *content)
+{
+	ifstream fin(filename.c_str(), ios::in | ios::binary);
+	if (!fin.is_open())
+		return false;
+	stringstream ss;
+	ss << fin.rdbuf();
+	*content = ss.str();
+	return true;
+}
+
+static vector<string> split_lines(const string &text)
+{
+	vector<string> lines;
+	stringstream ss(text);
+	string line;
+	while (getline(ss, line))
+	{
+		if (!line.empty() && line[line.length() - 1] == '\r')
+			line.erase(line.length() - 1);
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+/* keeps only the registers and data memory printed after the program terminated, and the execution log */
+static vector<string> extract_sections(const vector<string> &lines)
+{
+	vector<string> sections;
+	bool terminated = false;
+	bool inside = false;
+	for (unsigned i = 0; i < lines.size(); i++)
+	{
+		const string &line = lines[i];
+		if (line.compare(0, 18, "PROGRAM TERMINATED") == 0)
+			terminated = true;
+		bool header = line.compare(0, 25, "GENERAL PURPOSE REGISTERS") == 0 || line.compare(0, 12, "DATA MEMORY[") == 0;
+		if (line.compare(0, 13, "EXECUTION LOG") == 0 || (terminated && header))
+			inside = true;
+		else if (line.empty() || (!line.empty() && line[0] != ' ' && line.compare(0, 2, "0x") != 0 && line.compare(0, 8, "Register") != 0))
+			inside = false;
+		if (inside)
+			sections.push_back(line);
+	}
+	return sections;
+}
+
+/* returns true if the two outputs are the same; otherwise describes the first difference */
+static bool compare(const vector<string> &expected, const vector<string> &actual, string *diff)
+{
+	unsigned n = max(expected.size(), actual.size());
+	for (unsigned i = 0; i < n; i++)
+	{
+		const string e = i < expected.size() ? expected[i] : "<end of output>";
+		const string a = i < actual.size() ? actual[i] : "<end of output>";
+		if (e != a)
+		{
+			stringstream ss;
+			ss << "line " << i + 1 << ": expected \"" << e << "\", got \"" << a << "\"";
+			*diff = ss.str();
+			return false;
+		}
+	}
+	return true;
+}
+
+static void run_testcase(test_result_t *result, const vector<string> &references, bool sections_only)
+{
+	string command = result->command + " 2>&1";
+	double start = now_ms();
+	FILE *pipe = popen(command.c_str(), "r");
+	if (pipe == NULL)
+	{
+		result->status = -1;
+		return;
+	}
+	char buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+		result->output.append(buffer, n);
+	result->status = pclose(pipe);
+	result->wall_ms = now_ms() - start;
+
+	vector<string> actual = split_lines(result->output);
+	if (sections_only)
+		actual = extract_sections(actual);
+	result->matched = -1;
+	for (unsigned r = 0; r < references.size(); r++)
+	{
+		stringstream filename;
+		filename << references[r] << "/" << result->reference << ".out";
+		string content, diff;
+		if (!read_file(filename.str(), &content))
+		{
+			if (r == 0)
+				result->first_diff = "missing reference " + filename.str();
+			continue;
+		}
+		vector<string> expected = split_lines(content);
+		if (sections_only)
+			expected = extract_sections(expected);
+		if (compare(expected, actual, &diff))
+		{
+			result->matched = r;
+			break;
+		}
+		if (r == 0)
+			result->first_diff = diff;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bool sections_only = false;
+	bool verbose = false;
+	unsigned num_tests = 10;
+	unsigned jobs = thread::hardware_concurrency();
+	vector<string> references;
+
+	for (int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "-s")
+			sections_only = true;
+		else if (arg == "-v")
+			verbose = true;
+		else if (arg == "-j" && a + 1 < argc)
+			jobs = atoi(argv[++a]);
+		else if (arg == "-n" && a + 1 < argc)
+			num_tests = atoi(argv[++a]);
+		else if (arg == "-g" && a + 1 < argc)
+			references.push_back(argv[++a]);
+		else
+		{
+			cerr << "usage: regress [-s] [-j <jobs>] [-n <number of testcases>] [-g <reference dir>]... [-v]" << endl;
+			return -1;
+		}
+	}
+	if (references.empty())
+	{
+		references.push_back("testcases");
+		references.push_back("testcases/accurate_address_calculation");
+	}
+	if (jobs == 0)
+		jobs = 1;
+
+	test_result_t blank;
+	blank.status = 0;
+	blank.wall_ms = 0;
+	blank.matched = -1;
+	vector<test_result_t> results(num_tests, blank);
+	for (unsigned t = 0; t < num_tests; t++)
+	{
+		stringstream name;
+		name << "testcase" << t + 1;
+		results[t].name = name.str();
+		results[t].command = testcase_binary(t + 1);
+		results[t].reference = name.str();
+	}
+	glob_t configs;
+	if (glob("configs/*.ini", 0, NULL, &configs) == 0)
+	{
+		for (size_t c = 0; c < configs.gl_pathc; c++)
+		{
+			test_result_t result = blank;
+			string path = configs.gl_pathv[c];
+			result.name = path;
+			result.command = "bin/simulate " + path;
+			result.reference = path.substr(8, path.length() - 12);
+			results.push_back(result);
+		}
+		globfree(&configs);
+	}
+	if (glob("configs/*.multicore", 0, NULL, &configs) == 0)
+	{
+		for (size_t c = 0; c < configs.gl_pathc; c++)
+		{
+			test_result_t result = blank;
+			string path = configs.gl_pathv[c];
+			string content, arguments;
+			result.name = path;
+			result.reference = path.substr(8, path.length() - 18);
+			if (read_file(path, &content))
+			{
+				vector<string> lines = split_lines(content);
+				for (unsigned l = 0; l < lines.size() && arguments.empty(); l++)
+				{
+					if (!lines[l].empty() && lines[l][0] != '#')
+						arguments = lines[l];
+				}
+			}
+			result.command = "bin/multicore " + arguments;
+			results.push_back(result);
+		}
+		globfree(&configs);
+	}
+	num_tests = results.size();
+
+	//each worker picks the next testcase to run
+	unsigned next = 0;
+	mutex lock;
+	vector<thread> workers;
+	double start = now_ms();
+	for (unsigned w = 0; w < min(jobs, num_tests); w++)
+	{
+		workers.push_back(thread([&]()
+								 {
+			while (true)
+			{
+				unsigned t;
+				{
+					lock_guard<mutex> guard(lock);
+					if (next == num_tests)
+						return;
+					t = next++;
+				}
+				run_testcase(&results[t], references, sections_only);
+			} }));
+	}
+	for (unsigned w = 0; w < workers.size(); w++)
+		workers[w].join();
+	double wall_ms = now_ms() - start;
+
+	unsigned passed = 0;
+	double total_ms = 0;
+	cout << setfill(' ') << left << setw(28) << "Test" << setw(8) << "Result" << setw(42) << "Reference" << right << setw(10) << "Time (ms)" << endl;
+	for (unsigned t = 0; t < num_tests; t++)
+	{
+		test_result_t *result = &results[t];
+		cout << left << setw(28) << result->name;
+		if (result->matched >= 0 && result->status == 0)
+		{
+			cout << setw(8) << "PASS" << setw(42) << references[result->matched];
+			passed++;
+		}
+		else
+			cout << setw(8) << "FAIL" << setw(42) << (result->status != 0 ? "exit status != 0" : "-");
+		cout << right << setw(10) << fixed << setprecision(1) << result->wall_ms << endl;
+		if (result->matched < 0 && (verbose || result->status == 0) && !result->first_diff.empty())
+			cout << "    " << result->first_diff << endl;
+		total_ms += result->wall_ms;
+	}
+	cout << endl
+		 << passed << "/" << num_tests << " passed" << (sections_only ? " (architectural state and execution log only)" : "") << endl;
+	cout << "Wall time " << wall_ms << " ms with " << workers.size() << " jobs (sum of testcase times " << total_ms << " ms)" << endl;
+	return passed == num_tests ? 0 : 1;
+}
@@ -0,0 +1,383 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+/* Batch simulation server
+   Reads simulation jobs from stdin, or from the clients of a local Unix socket with -u, and
+   writes back one result line per job as soon as it completes. The simulators are allocated
+   once and reused for every job through sim_ooo::reconfigure, so a job only pays for the
+   reset of the simulator and for the parsing of its program.
+   With -u, each client is served by its own host thread, and a job waits until one of the
+   <pool> simulators is free.
+
+   usage: server [-u <socket path>] [-j <pool>] [-m <memory size>] [-c <max cycles>]
+	-c <max cycles>                     clock cycles after which a job is stopped (default 10000000)
+
+   A job is a block of lines terminated by "run"; the lines are
+	program <file.asm>                  assembly program (required)
+	config <rob>,<int>,<add>,<mult>,<load>[,<issue width>[,<vector>]]  (default 16,4,4,4,4,1);
+	                                    the ROB and the reservation stations have fewer than 65535 entries
+	unit <UNIT> <latency> [<instances>] execution unit (INTEGER, ADDER, MULTIPLIER, DIVIDER, MEMORY, VECTOR, FMA);
+	                                    without unit lines, the units of the testcases are used; a job
+	                                    has at most 10 instances (MAX_UNITS) in all
+	R<n> <value>, F<n> <value>, V<n> <v0> <v1> <v2> <v3>, M <address> <value>
+	                                    initial registers and memory (see sim_ooo::load_state)
+	state <file>                        initial registers and memory from a file
+	image <address> <file>              memory image (see sim_ooo::load_memory_image)
+	cycles <n>                          stops after n clock cycles, if the program has not completed yet
+	                                    (default 0: up to the maximum set with -c)
+	report <R<n>|F<n>|M<address>>...    registers and memory words added to the result
+	run [<id>]                          runs the job (the id defaults to the number of the job)
+   Empty lines and lines starting with '#' are ignored; "quit" closes the connection.
+   Results are
+	result <id> cycles <cycles> instructions <instructions> ipc <IPC> completed <0|1> [<report>=<value>...]
+	error <id> <message>
+   Errors in the program and in the initial state are reported as job errors.
+*/
+
+typedef struct
+{
+	exe_unit_t type;
+	unsigned latency;
+	unsigned instances;
+} unit_spec_t;
+
+typedef struct
+{
+	string program;
+	unsigned config[7];
+	vector<unit_spec_t> units;
+	string state;				// initial state lines
+	vector<string> state_files; // initial state files
+	unsigned cycles;
+	vector<string> report;
+} job_t;
+
+static const char *unit_names[NUM_UNIT_TYPES] = {"INTEGER", "ADDER", "MULTIPLIER", "DIVIDER", "MEMORY", "VECTOR", "FMA"};
+
+/* pool of simulators shared by the client threads */
+static vector<sim_ooo *> pool;
+static unsigned mem_size = 1024 * 1024;
+static unsigned max_cycles = 10000000;
+static mutex pool_lock;
+static condition_variable pool_free;
+
+static sim_ooo *acquire_simulator()
+{
+	unique_lock<mutex> guard(pool_lock);
+	pool_free.wait(guard, []()
+				   { return !pool.empty(); });
+	sim_ooo *ooo = pool.back();
+	pool.pop_back();
+	return ooo;
+}
+
+static void release_simulator(sim_ooo *ooo)
+{
+	{
+		lock_guard<mutex> guard(pool_lock);
+		pool.push_back(ooo);
+	}
+	pool_free.notify_one();
+}
+
+static void clear_job(job_t *job)
+{
+	static const unsigned default_config[7] = {16, 4, 4, 4, 4, 1, 0};
+	job->program.clear();
+	memcpy(job->config, default_config, sizeof(default_config));
+	job->units.clear();
+	job->state.clear();
+	job->state_files.clear();
+	job->cycles = 0;
+	job->report.clear();
+}
+
+/* parses one line of a job; returns false (and an error message) if it is invalid */
+static bool parse_line(job_t *job, const string &line, string *error)
+{
+	stringstream ss(line);
+	string keyword;
+	ss >> keyword;
+	if (keyword == "program")
+	{
+		if (!(ss >> job->program) || access(job->program.c_str(), R_OK) != 0)
+		{
+			*error = "cannot read program " + job->program;
+			return false;
+		}
+	}
+	else if (keyword == "config")
+	{
+		string list, field;
+		unsigned n = 0;
+		ss >> list;
+		stringstream fields(list);
+		while (n < 7 && getline(fields, field, ','))
+			job->config[n++] = strtoul(field.c_str(), NULL, 0);
+		//the ROB indices must fit in the operand tags (see sim_ooo::init_window); the reservation stations are bounded the same way
+		bool valid = n >= 5 && job->config[0] != 0 && job->config[5] != 0;
+		for (unsigned k = 0; k < 7; k++)
+			if (k != 5 && job->config[k] >= NO_TAG)
+				valid = false;
+		if (!valid)
+		{
+			*error = "invalid config " + list;
+			return false;
+		}
+	}
+	else if (keyword == "unit")
+	{
+		string name;
+		unit_spec_t unit;
+		unit.instances = 1;
+		bool valid = (bool)(ss >> name >> unit.latency);
+		ss >> unit.instances;
+		unsigned t = 0;
+		while (t < NUM_UNIT_TYPES && name != unit_names[t])
+			t++;
+		//the instances of all the units must fit in the execution units of the simulator
+		unsigned instances = unit.instances;
+		for (unsigned u = 0; u < job->units.size(); u++)
+			instances += job->units[u].instances;
+		if (!valid || t == NUM_UNIT_TYPES || unit.instances == 0 || unit.instances > MAX_UNITS || instances > MAX_UNITS)
+		{
+			*error = "invalid unit " + name;
+			return false;
+		}
+		unit.type = (exe_unit_t)t;
+		job->units.push_back(unit);
+	}
+	else if (keyword == "state")
+	{
+		string filename;
+		if (!(ss >> filename) || access(filename.c_str(), R_OK) != 0)
+		{
+			*error = "cannot read state " + filename;
+			return false;
+		}
+		job->state_files.push_back(filename);
+	}
+	else if (keyword == "cycles")
+		ss >> job->cycles;
+	else if (keyword == "report")
+	{
+		string target;
+		while (ss >> target)
+			job->report.push_back(target);
+	}
+	else if (keyword == "image")
+	{
+		string address, filename;
+		if (!(ss >> address >> filename) || access(filename.c_str(), R_OK) != 0)
+		{
+			*error = "cannot read image " + filename;
+			return false;
+		}
+		job->state += line + "\n";
+	}
+	else if (keyword == "M" || ((keyword[0] == 'R' || keyword[0] == 'F' || keyword[0] == 'V') && isdigit(keyword[1])))
+	{
+		string value;
+		if (!(ss >> value))
+		{
+			*error = "missing value in " + line;
+			return false;
+		}
+		job->state += line + "\n";
+	}
+	else
+	{
+		*error = "unknown line " + line;
+		return false;
+	}
+	return true;
+}
+
+/* runs a job on a simulator of the pool and formats its result */
+static string run_job(const job_t *job, const string &id)
+{
+	sim_ooo *ooo = acquire_simulator();
+	ooo->reconfigure(job->config[0], job->config[1], job->config[2], job->config[3], job->config[4], job->config[5], job->config[6]);
+	if (job->units.empty())
+	{
+		ooo->init_exec_unit(INTEGER, 2, 1);
+		ooo->init_exec_unit(ADDER, 2, 2);
+		ooo->init_exec_unit(MULTIPLIER, 10, 1);
+		ooo->init_exec_unit(DIVIDER, 40, 1);
+		ooo->init_exec_unit(MEMORY, 1, 1);
+	}
+	for (unsigned u = 0; u < job->units.size(); u++)
+		ooo->init_exec_unit(job->units[u].type, job->units[u].latency, job->units[u].instances);
+	bool loaded = ooo->load_program(job->program.c_str(), 0x00000000);
+	for (unsigned f = 0; loaded && f < job->state_files.size(); f++)
+		loaded = ooo->load_state(job->state_files[f].c_str());
+	stringstream state(job->state);
+	if (loaded)
+		loaded = ooo->load_state(state, "<job>");
+	if (!loaded)
+	{
+		string error = ooo->get_load_error();
+		release_simulator(ooo);
+		return "error " + id + " " + error;
+	}
+
+	ooo->run_until(job->cycles == 0 ? max_cycles : min(job->cycles, max_cycles));
+
+	stringstream result;
+	result << "result " << id << " cycles " << ooo->get_clock_cycles() << " instructions " << ooo->get_instructions_executed();
+	result << " ipc " << fixed << setprecision(4) << ooo->get_IPC() << " completed " << ooo->program_completed();
+	for (unsigned r = 0; r < job->report.size(); r++)
+	{
+		const string &target = job->report[r];
+		unsigned index = strtoul(target.c_str() + 1, NULL, 0);
+		result << " " << target << "=";
+		if (target[0] == 'R' && index < NUM_GP_REGISTERS)
+			result << ooo->get_int_register(index);
+		else if (target[0] == 'F' && index < NUM_GP_REGISTERS)
+			result << ooo->get_fp_register(index);
+		else if (target[0] == 'M' && index + 4 <= mem_size)
+			result << hex << "0x" << setw(8) << setfill('0') << ooo->read_memory(index) << dec << setfill(' ');
+		else
+			result << "?";
+	}
+	release_simulator(ooo);
+	return result.str();
+}
+
+/* reads jobs from "in" and writes their results to "out" until the end of the input or "quit" */
+static void serve(FILE *in, FILE *out)
+{
+	job_t job;
+	clear_job(&job);
+	bool failed = false;
+	string error;
+	unsigned jobs = 0;
+	char *buffer = NULL;
+	size_t size = 0;
+	while (getline(&buffer, &size, in) != -1)
+	{
+		string line = buffer;
+		line.erase(line.find_last_not_of(" \t\r\n") + 1);
+		line.erase(0, line.find_first_not_of(" \t"));
+		if (line.empty() || line[0] == '#')
+			continue;
+		if (line == "quit")
+			break;
+		if (line.compare(0, 3, "run") == 0 && (line.length() == 3 || line[3] == ' '))
+		{
+			stringstream id;
+			id << ++jobs;
+			string name = line.length() > 4 ? line.substr(4) : id.str();
+			if (!failed && job.program.empty())
+			{
+				failed = true;
+				error = "missing program";
+			}
+			string result = failed ? "error " + name + " " + error : run_job(&job, name);
+			fputs((result + "\n").c_str(), out);
+			fflush(out);
+			clear_job(&job);
+			failed = false;
+		}
+		else if (!failed)
+			failed = !parse_line(&job, line, &error);
+	}
+	free(buffer);
+}
+
+static void serve_client(int fd)
+{
+	FILE *in = fdopen(fd, "r");
+	FILE *out = fdopen(dup(fd), "w");
+	if (in != NULL && out != NULL)
+		serve(in, out);
+	if (in != NULL)
+		fclose(in);
+	if (out != NULL)
+		fclose(out);
+}
+
+static void usage()
+{
+	cerr << "usage: server [-u <socket path>] [-j <pool>] [-m <memory size>] [-c <max cycles>]" << endl;
+	exit(-1);
+}
+
+int main(int argc, char **argv)
+{
+	string socket_path;
+	unsigned pool_size = 0;
+
+	for (int a = 1; a < argc; a++)
+	{
+		string arg = argv[a];
+		if (arg == "-u" && a + 1 < argc)
+			socket_path = argv[++a];
+		else if (arg == "-j" && a + 1 < argc)
+			pool_size = atoi(argv[++a]);
+		else if (arg == "-m" && a + 1 < argc)
+			mem_size = strtoul(argv[++a], NULL, 0);
+		else if (arg == "-c" && a + 1 < argc)
+			max_cycles = strtoul(argv[++a], NULL, 0);
+		else
+			usage();
+	}
+	if (max_cycles == 0)
+		usage();
+	if (pool_size == 0)
+		pool_size = socket_path.empty() ? 1 : max(1u, thread::hardware_concurrency());
+
+	//the simulators are reconfigured by each job
+	for (unsigned p = 0; p < pool_size; p++)
+	{
+		pool.push_back(new sim_ooo(mem_size, 16, 4, 4, 4, 4));
+		pool.back()->exit_on_load_error(false);
+	}
+
+	if (socket_path.empty())
+	{
+		serve(stdin, stdout);
+		return 0;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (listener < 0 || socket_path.length() >= sizeof(address.sun_path))
+	{
+		cerr << "error: cannot create socket " << socket_path << "!" << endl;
+		return -1;
+	}
+	strcpy(address.sun_path, socket_path.c_str());
+	unlink(socket_path.c_str());
+	if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 16) != 0)
+	{
+		cerr << "error: cannot listen on socket " << socket_path << "!" << endl;
+		return -1;
+	}
+	while (true)
+	{
+		int fd = accept(listener, NULL, NULL);
+		if (fd >= 0)
+			thread(serve_client, fd).detach();
+	}
+	return 0;
+}
@@ -0,0 +1,418 @@
+#include "sim_ooo.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+
+using namespace std;
+
+/* Configuration-driven simulator
+   Builds a processor, loads its program and initial state, runs it and prints the requested
+   dumps as described by an INI file, so that an experiment does not need its own testcase
+   program. The output has the same layout as the testcases (see configs/testcase*.ini, which
+   reproduce them).
+
+   usage: simulate <config.ini> [<section>.<key>=<value>]...
+	(the assignments override the configuration file, e.g. processor.rob=32; units.<UNIT>=... adds a unit)
+
+   [processor]
+	memory = <bytes>                 data memory (default 1MB)
+	rob = <entries>                  (default 16)
+	int_rs, add_rs, mult_rs, load_buffers, vector_rs = <entries>  reservation stations (default 4,4,4,4,0)
+	issue_width = <width>            (default 1)
+	threads = <threads>[,icount][,partitioned]  hardware threads, fetch policy and ROB partitioning
+	prf = <int regs>,<fp regs>       merged physical register files
+	frontend = <width>,<decode>,<queue>[,<icache size>,<assoc>,<line>,<miss latency>]  decoupled front-end
+	loop_buffer = <instructions>     loop buffer of the decoupled front-end (see sim_ooo::init_loop_buffer)
+	store_buffer = <entries>[,<drain cycles>[,<line>]]  post-commit store buffer (see sim_ooo::init_store_buffer)
+	select = position|oldest|random|critical  scheduler select policy
+	move_elimination = yes           resolves zero idioms and moves at rename (see sim_ooo::enable_move_elimination)
+	fusion = yes                     issues compare-and-branch and address-and-load pairs fused (see sim_ooo::enable_fusion)
+   [energy]                          energy table (see sim_ooo::set_event_energy; the defaults are used for the missing keys)
+	rs_write, cdb_broadcast, rob_read, rob_write, rf_read, rf_write, mem_read, mem_write = <pJ>  energy per event
+	<UNIT> = <pJ>                    energy per operation of an execution unit type
+	leak_rob, leak_rs, leak_registers, leak_units = <pJ>  leakage per entry and clock cycle
+	frequency = <GHz>                clock frequency used for the average power (default 1)
+   [units]
+	<UNIT> = <latency>[x<instances>] execution units (INTEGER, ADDER, MULTIPLIER, DIVIDER, MEMORY, VECTOR, FMA),
+	                                 added in the order of the file; at most 10 instances (MAX_UNITS) in all
+   [program]
+	file = <program.asm>             program of thread 0 (file<t> for thread t)
+	base = <address>                 address of the programs (default 0)
+   [state]
+	R<n>, F<n> = <value>; V<n> = <v0> <v1> <v2> <v3>; M<address> = <value>   initial registers and memory of
+	                                 thread 0 (see sim_ooo::load_state)
+	file = <state file>              initial state of thread 0 from a file (file<t> for thread t)
+	image<address> = <file>          memory image loaded at address (see sim_ooo::load_memory_image)
+   [run]
+	trace = <cycles>                 cycles simulated one at a time, printing the status after each of them
+	cycles = <cycles>                stops the program after this many cycles (default 0: runs it to completion)
+	histograms = <file.json>         collects and writes the occupancy and latency histograms
+	profile = yes                    prints the per-PC profile at the end of the run
+	skip = no                        simulates the idle cycles one by one (see sim_ooo::enable_idle_skipping)
+   [output]
+	before = <dumps>                 printed before the program starts
+	trace = <dumps>                  printed after the traced cycles
+	after = <dumps>                  printed after the program terminates
+   where <dumps> is a comma-separated list of registers, status, rob, reservation_stations, pending,
+   memory <start> <end>, image <file> <start> <end> (raw memory dump), log, stats, threads, prf, frontend, elimination,
+   fusion, store_buffer, energy, dataflow
+*/
+
+typedef map<string, string> section_t;
+typedef map<string, section_t> config_t;
+
+static void usage()
+{
+	cerr << "usage: simulate <config.ini> [<section>.<key>=<value>]..." << endl;
+	exit(-1);
+}
+
+static string trim(const string &s)
+{
+	size_t first = s.find_first_not_of(" \t\r");
+	if (first == string::npos)
+		return "";
+	return s.substr(first, s.find_last_not_of(" \t\r") - first + 1);
+}
+
+/* reads an INI file: "[section]" headers, "key = value" lines, and comments starting with '#' or ';' */
+static void read_config(const char *filename, config_t *config, vector<pair<string, string> > *ordered_units)
+{
+	ifstream fin(filename, ios::in);
+	if (!fin.is_open())
+	{
+		cerr << "error: open file " << filename << " failed!" << endl;
+		exit(-1);
+	}
+	string line, section;
+	unsigned line_nr = 0;
+	while (getline(fin, line))
+	{
+		line_nr++;
+		line = trim(line);
+		if (line.empty() || line[0] == '#' || line[0] == ';')
+			continue;
+		if (line[0] == '[' && line[line.length() - 1] == ']')
+		{
+			section = trim(line.substr(1, line.length() - 2));
+			continue;
+		}
+		size_t eq = line.find('=');
+		if (eq == string::npos || section.empty())
+		{
+			cerr << "error: " << filename << ":" << line_nr << ": invalid line!" << endl;
+			exit(-1);
+		}
+		string key = trim(line.substr(0, eq));
+		string value = trim(line.substr(eq + 1));
+		if (section == "units")
+			ordered_units->push_back(make_pair(key, value));
+		else
+			(*config)[section][key] = value;
+	}
+}
+
+static string get(config_t &config, const string &section, const string &key, const string &value = "")
+{
+	section_t &s = config[section];
+	return s.count(key) ? s[key] : value;
+}
+
+static unsigned get_unsigned(config_t &config, const string &section, const string &key, unsigned value)
+{
+	string s = get(config, section, key);
+	return s.empty() ? value : strtoul(s.c_str(), NULL, 0);
+}
+
+/* parses a comma-separated list of at most "max" numbers; returns how many were found */
+static unsigned parse_list(const string &arg, unsigned *values, unsigned max)
+{
+	stringstream ss(arg);
+	string field;
+	unsigned n = 0;
+	while (n < max && getline(ss, field, ','))
+		values[n++] = strtoul(field.c_str(), NULL, 0);
+	return n;
+}
+
+static void dump(sim_ooo *ooo, const string &dumps)
+{
+	stringstream ss(dumps);
+	string item;
+	while (getline(ss, item, ','))
+	{
+		stringstream words(item);
+		string what;
+		words >> what;
+		if (what.empty())
+			continue;
+		if (what == "registers")
+			ooo->print_registers();
+		else if (what == "status")
+			ooo->print_status();
+		else if (what == "rob")
+			ooo->print_rob();
+		else if (what == "reservation_stations")
+			ooo->print_reservation_stations();
+		else if (what == "pending")
+			ooo->print_pending_instructions();
+		else if (what == "memory")
+		{
+			string start, end;
+			if (!(words >> start >> end))
+			{
+				cerr << "error: memory dump needs a start and an end address!" << endl;
+				exit(-1);
+			}
+			ooo->print_memory(strtoul(start.c_str(), NULL, 0), strtoul(end.c_str(), NULL, 0));
+		}
+		else if (what == "image")
+		{
+			string filename, start, end;
+			if (!(words >> filename >> start >> end))
+			{
+				cerr << "error: image dump needs a file, a start and an end address!" << endl;
+				exit(-1);
+			}
+			ooo->dump_memory_image(filename.c_str(), strtoul(start.c_str(), NULL, 0), strtoul(end.c_str(), NULL, 0));
+		}
+		else if (what == "log")
+		{
+			cout << endl;
+			ooo->print_log();
+		}
+		else if (what == "stats")
+		{
+			cout << endl;
+			cout << "Instruction executed = " << dec << ooo->get_instructions_executed() << endl;
+			cout << "Clock cycles = " << dec << ooo->get_clock_cycles() << endl;
+			cout << "IPC = " << dec << ooo->get_IPC() << endl;
+		}
+		else if (what == "threads")
+			ooo->print_thread_stats();
+		else if (what == "prf")
+			ooo->print_prf_stats();
+		else if (what == "frontend")
+			ooo->print_frontend_stats();
+		else if (what == "elimination")
+			ooo->print_elimination_stats();
+		else if (what == "fusion")
+			ooo->print_fusion_stats();
+		else if (what == "store_buffer")
+			ooo->print_store_buffer_stats();
+		else if (what == "energy")
+			ooo->print_energy_stats();
+		else if (what == "dataflow")
+			ooo->print_dataflow_limit();
+		else
+		{
+			cerr << "error: unknown dump " << what << "!" << endl;
+			exit(-1);
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	static const char *unit_names[NUM_UNIT_TYPES] = {"INTEGER", "ADDER", "MULTIPLIER", "DIVIDER", "MEMORY", "VECTOR", "FMA"};
+	static const char *select_names[NUM_SELECT_POLICIES] = {"position", "oldest", "random", "critical"};
+	static const char *event_keys[NUM_ENERGY_EVENTS] = {"rs_write", "cdb_broadcast", "rob_read", "rob_write", "rf_read", "rf_write", "mem_read", "mem_write"};
+	static const char *leakage_keys[NUM_LEAKAGE_STRUCTURES] = {"leak_rob", "leak_rs", "leak_registers", "leak_units"};
+
+	if (argc < 2)
+		usage();
+	config_t config;
+	vector<pair<string, string> > units;
+	read_config(argv[1], &config, &units);
+	for (int a = 2; a < argc; a++)
+	{
+		string arg = argv[a];
+		size_t dot = arg.find('.'), eq = arg.find('=');
+		if (dot == string::npos || eq == string::npos || eq < dot)
+			usage();
+		if (arg.substr(0, dot) == "units")
+			units.push_back(make_pair(arg.substr(dot + 1, eq - dot - 1), arg.substr(eq + 1)));
+		else
+			config[arg.substr(0, dot)][arg.substr(dot + 1, eq - dot - 1)] = arg.substr(eq + 1);
+	}
+
+	//processor
+	sim_ooo *ooo = new sim_ooo(get_unsigned(config, "processor", "memory", 1024 * 1024),
+							   get_unsigned(config, "processor", "rob", 16),
+							   get_unsigned(config, "processor", "int_rs", 4),
+							   get_unsigned(config, "processor", "add_rs", 4),
+							   get_unsigned(config, "processor", "mult_rs", 4),
+							   get_unsigned(config, "processor", "load_buffers", 4),
+							   get_unsigned(config, "processor", "issue_width", 1),
+							   get_unsigned(config, "processor", "vector_rs", 0));
+	unsigned total_instances = 0;
+	for (unsigned u = 0; u < units.size(); u++)
+	{
+		unsigned t = 0;
+		while (t < NUM_UNIT_TYPES && units[u].first != unit_names[t])
+			t++;
+		unsigned latency, instances = 1;
+		if (t == NUM_UNIT_TYPES || sscanf(units[u].second.c_str(), "%ux%u", &latency, &instances) < 1 || instances == 0 ||
+			instances > MAX_UNITS || (total_instances += instances) > MAX_UNITS)
+		{
+			cerr << "error: invalid unit " << units[u].first << " = " << units[u].second << "!" << endl;
+			exit(-1);
+		}
+		ooo->init_exec_unit((exe_unit_t)t, latency, instances);
+	}
+	string threads = get(config, "processor", "threads");
+	if (!threads.empty())
+		ooo->init_threads(atoi(threads.c_str()), threads.find("icount") != string::npos ? FETCH_ICOUNT : FETCH_ROUND_ROBIN, threads.find("partitioned") != string::npos);
+	unsigned prf[2] = {0, 0};
+	if (parse_list(get(config, "processor", "prf"), prf, 2) == 2)
+		ooo->init_prf(prf[0], prf[1]);
+	unsigned frontend[7] = {0, 0, 0, 0, 1, 32, 10};
+	if (parse_list(get(config, "processor", "frontend"), frontend, 7) >= 3)
+		ooo->init_frontend(frontend[0], frontend[1], frontend[2], frontend[3], frontend[4], frontend[5], frontend[6]);
+	unsigned loop_buffer = get_unsigned(config, "processor", "loop_buffer", 0);
+	if (loop_buffer)
+		ooo->init_loop_buffer(loop_buffer);
+	unsigned store_buffer[3] = {0, 1, 32};
+	if (parse_list(get(config, "processor", "store_buffer"), store_buffer, 3) >= 1)
+		ooo->init_store_buffer(store_buffer[0], store_buffer[1], store_buffer[2]);
+	string select = get(config, "processor", "select");
+	if (!select.empty())
+	{
+		unsigned p = 0;
+		while (p < NUM_SELECT_POLICIES && select != select_names[p])
+			p++;
+		if (p == NUM_SELECT_POLICIES)
+		{
+			cerr << "error: unknown select policy " << select << "!" << endl;
+			exit(-1);
+		}
+		ooo->set_select_policy((select_policy_t)p);
+	}
+	ooo->enable_move_elimination(get(config, "processor", "move_elimination") == "yes");
+	ooo->enable_fusion(get(config, "processor", "fusion") == "yes");
+
+	//energy table
+	section_t &energy = config["energy"];
+	for (section_t::iterator it = energy.begin(); it != energy.end(); ++it)
+	{
+		double value = atof(it->second.c_str());
+		unsigned k = 0;
+		if (it->first == "frequency")
+		{
+			ooo->set_clock_frequency(value);
+			continue;
+		}
+		while (k < NUM_ENERGY_EVENTS && it->first != event_keys[k])
+			k++;
+		if (k < NUM_ENERGY_EVENTS)
+		{
+			ooo->set_event_energy((energy_event_t)k, value);
+			continue;
+		}
+		k = 0;
+		while (k < NUM_LEAKAGE_STRUCTURES && it->first != leakage_keys[k])
+			k++;
+		if (k < NUM_LEAKAGE_STRUCTURES)
+		{
+			ooo->set_leakage((leakage_structure_t)k, value);
+			continue;
+		}
+		k = 0;
+		while (k < NUM_UNIT_TYPES && it->first != unit_names[k])
+			k++;
+		if (k == NUM_UNIT_TYPES)
+		{
+			cerr << "error: unknown energy key " << it->first << "!" << endl;
+			exit(-1);
+		}
+		ooo->set_unit_energy((exe_unit_t)k, value);
+	}
+
+	//programs and initial state
+	unsigned base = get_unsigned(config, "program", "base", 0);
+	section_t &program = config["program"];
+	if (!program.count("file"))
+	{
+		cerr << "error: no program file!" << endl;
+		exit(-1);
+	}
+	for (section_t::iterator it = program.begin(); it != program.end(); ++it)
+		if (it->first.compare(0, 4, "file") == 0)
+			ooo->load_program(it->second.c_str(), base, atoi(it->first.c_str() + 4));
+	stringstream state;
+	section_t &initial = config["state"];
+	for (section_t::iterator it = initial.begin(); it != initial.end(); ++it)
+	{
+		if (it->first.compare(0, 4, "file") == 0)
+			ooo->load_state(it->second.c_str(), atoi(it->first.c_str() + 4));
+		else if (it->first[0] == 'M')
+			state << "M " << it->first.substr(1) << " " << it->second << endl;
+		else if (it->first.compare(0, 5, "image") == 0)
+			state << "image " << it->first.substr(5) << " " << it->second << endl;
+		else
+			state << it->first << " " << it->second << endl;
+	}
+	ooo->load_state(state, argv[1]);
+
+	unsigned trace = get_unsigned(config, "run", "trace", 0);
+	unsigned cycles = get_unsigned(config, "run", "cycles", 0);
+	string histograms = get(config, "run", "histograms");
+	ooo->enable_histograms(!histograms.empty());
+	ooo->enable_profiler(get(config, "run", "profile") == "yes");
+	ooo->enable_idle_skipping(get(config, "run", "skip") != "no");
+
+	cout << "\nBEFORE PROGRAM EXECUTION..." << endl;
+	cout << "======================================================================" << endl
+		 << endl;
+	dump(ooo, get(config, "output", "before"));
+
+	// executes the program
+	cout << "\n*****************************" << endl;
+	cout << "STARTING THE PROGRAM..." << endl;
+	cout << "*****************************" << endl
+		 << endl;
+
+	if (trace > 0)
+	{
+		cout << "First " << dec << trace << " clock cycles: inspecting the registers at each clock cycle..." << endl;
+		cout << "======================================================================" << endl
+			 << endl;
+		for (unsigned i = 0; i < trace; i++)
+		{
+			cout << "CLOCK CYCLE #" << dec << i << endl;
+			ooo->run(1);
+			ooo->print_status();
+			cout << endl;
+		}
+		dump(ooo, get(config, "output", "trace"));
+	}
+
+	cout << "EXECUTING PROGRAM TO COMPLETION..." << endl
+		 << endl;
+	if (cycles == 0)
+		ooo->run();
+	else
+		ooo->run_until(cycles);
+
+	if (ooo->program_completed())
+	{
+		cout << "PROGRAM TERMINATED\n";
+		cout << "===================" << endl
+			 << endl;
+	}
+	else
+	{
+		cout << "PROGRAM STOPPED AFTER " << dec << ooo->get_clock_cycles() << " CLOCK CYCLES\n";
+		cout << "======================================" << endl
+			 << endl;
+	}
+	dump(ooo, get(config, "output", "after"));
+
+	if (!histograms.empty())
+		ooo->dump_histograms(histograms.c_str());
+
+	delete ooo;
+	return 0;
+}